@@ -0,0 +1,140 @@
+#!/bin/python2
+
+import subprocess
+import re
+import os
+import math
+
+from optparse import OptionParser
+
+FAMILIES = ["geometric", "grid", "powerlaw", "complete"]
+SIZES = [1000, 10000, 100000, 1000000]
+KS = [10, 20, 50]
+
+# edges per node of the generated geometric and powerlaw instances
+DENSITY = 10
+
+METHODS = ["mtz", "mcf", "scf"]
+
+BIN = "./kmst"
+GEN = "./kmst-gen"
+DATADIR = "data/scaling/"
+
+PATTERNS = { "nodes": re.compile("Number of nodes:\s*(\d+)")
+           , "edges": re.compile("Number of edges:\s*(\d+)")
+           , "load": re.compile("Load time:\s*(\d+(?:\.\d+)?)")
+           , "build": re.compile("Build time:\s*(\d+(?:\.\d+)?)")
+           , "solve": re.compile("Solve time:\s*(\d+(?:\.\d+)?)")
+           , "time": re.compile("CPU time:\s*(\d+(?:\.\d+)?)")
+           , "memory": re.compile("Peak memory:\s*(\d+(?:\.\d+)?)")
+           , "status": re.compile("CPLEX status:\s*(\S+)")
+           , "objective": re.compile("Objective value:\s*(\S+)")
+           }
+
+# target: requested number of edges; nodes, edges: size of the generated
+# instance as read by kmst (including the artificial root and its edges);
+# solve: wall-clock time of the CPLEX solve only; time: CPU time of the run
+COLUMNS = ["family", "target", "nodes", "edges", "k", "load", "build", "solve", "time",
+           "memory", "status", "objective"]
+
+def nodes(family, edges):
+    """Nodes for about the given number of edges in each family."""
+    if family == "grid" or family == "torus":
+        return edges / 2
+    if family == "complete":
+        return int((1 + math.sqrt(1 + 8 * edges)) / 2)
+    return edges / DENSITY
+
+def instance(family, edges, seed):
+    path = "%s%s-%d-%d.dat" % (DATADIR, family, edges, seed)
+    if not os.path.exists(path):
+        subprocess.check_call([GEN, "-t", family, "-n", str(nodes(family, edges)),
+                               "-m", str(edges), "-s", str(seed), "-o", path])
+    return path
+
+def run(path, model, k, limit):
+    process = subprocess.Popen([BIN, "-q", "-f", path, "-m", model, "-k", str(k),
+                                "--time-limit", str(limit)],
+                               stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+    output = process.communicate()[0]
+    result = {}
+    for key, pattern in PATTERNS.items():
+        match = pattern.search(output)
+        result[key] = match.group(1) if match else ""
+    return result
+
+def plot(rows, model):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print "matplotlib not available, skipping plot for %s" % model
+        return
+
+    for family in FAMILIES:
+        for k in KS:
+            points = sorted((int(r["edges"]), float(r["solve"])) for r in rows
+                            if r["family"] == family and r["k"] == k and r["edges"] and r["solve"])
+            if points:
+                plt.loglog([p[0] for p in points], [p[1] for p in points], "o-",
+                           label = "%s, k = %d" % (family, k))
+    plt.xlabel("edges")
+    plt.ylabel("solve time [s]")
+    plt.title(model)
+    plt.legend(loc = "upper left")
+    plt.savefig("scaling-%s.png" % model)
+    plt.close()
+
+if __name__ == "__main__":
+    parser = OptionParser()
+    parser.add_option("-m", "--model", dest = "models",
+            help = "One of ['mtz', 'mcf', 'scf']", action = "append")
+    parser.add_option("-f", "--family", dest = "families",
+            help = "One of %s" % FAMILIES, action = "append")
+    parser.add_option("-e", "--edges", dest = "sizes", type = "int",
+            help = "Number of edges, may be repeated", action = "append")
+    parser.add_option("-k", dest = "ks", type = "int",
+            help = "Number of nodes in the tree, may be repeated (default %s)" % KS,
+            action = "append")
+    parser.add_option("-s", "--seed", dest = "seed", type = "int", default = 1)
+    parser.add_option("-t", "--time-limit", dest = "limit", type = "int", default = 600,
+            help = "Time limit per run in seconds")
+    (options, args) = parser.parse_args()
+
+    if options.models:
+        for m in options.models:
+            if m not in METHODS:
+                parser.error("Invalid model passed")
+    else:
+        options.models = METHODS
+    if options.families:
+        FAMILIES = options.families
+    if options.sizes:
+        SIZES = options.sizes
+    if options.ks:
+        KS = options.ks
+
+    if not os.path.isdir(DATADIR):
+        os.makedirs(DATADIR)
+
+    for meth in options.models:
+        rows = []
+        for family in FAMILIES:
+            for edges in SIZES:
+                path = instance(family, edges, options.seed)
+                for k in KS:
+                    result = run(path, meth, k, options.limit)
+                    result["family"] = family
+                    result["target"] = edges
+                    result["k"] = k
+                    rows.append(result)
+                    print "%s %s n = %s, m = %s, k = %d: load %s s, build %s s, solve %s s, %s MB, %s, objective %s" % (
+                            meth, family, result["nodes"], result["edges"], k, result["load"], result["build"],
+                            result["solve"], result["memory"], result["status"], result["objective"])
+
+        with open("scaling-%s.csv" % meth, "w") as f:
+            f.write(",".join(COLUMNS) + "\n")
+            for r in rows:
+                f.write(",".join(str(r[c]) for c in COLUMNS) + "\n")
+        plot(rows, meth)
@@ -0,0 +1,69 @@
+#include "BoundTable.h"
+
+#include <limits>
+
+static const double INF = numeric_limits<double>::infinity();
+
+BoundTable::BoundTable( int _max_k, bool _monotone ) :
+	max_k( _max_k ), monotone( _monotone ), upper( _max_k + 1, INF ), lower( _max_k + 1, -INF ), trees( _max_k + 1 )
+{
+}
+
+bool BoundTable::offerTree( int k, const Solution& tree )
+{
+	if( k < 1 || k > max_k ) return false;
+
+	lock_guard<mutex> guard( lock );
+	if( tree.weight >= upper[k] ) return false;
+	upper[k] = tree.weight;
+	trees[k] = tree;
+	return true;
+}
+
+void BoundTable::offerLowerBound( int k, double bound )
+{
+	if( k < 1 || k > max_k ) return;
+
+	lock_guard<mutex> guard( lock );
+	if( bound > lower[k] ) lower[k] = bound;
+}
+
+double BoundTable::upperBound( int k ) const
+{
+	lock_guard<mutex> guard( lock );
+	double best = INF;
+	const int last = monotone ? max_k : min( k, max_k );
+	for( int j = max( k, 1 ); j <= last; j++ ) best = min( best, upper[j] );
+	return best;
+}
+
+double BoundTable::lowerBound( int k ) const
+{
+	lock_guard<mutex> guard( lock );
+	double best = -INF;
+	for( int j = monotone ? 1 : max( k, 1 ); j <= min( k, max_k ); j++ ) best = max( best, lower[j] );
+	return best;
+}
+
+bool BoundTable::tree( int k, Solution& tree ) const
+{
+	if( k < 1 || k > max_k ) return false;
+
+	lock_guard<mutex> guard( lock );
+	if( upper[k] == INF ) return false;
+	tree = trees[k];
+	return true;
+}
+
+int BoundTable::upperTree( int k, Solution& tree ) const
+{
+	lock_guard<mutex> guard( lock );
+	int best = 0;
+	for( int j = max( k, 1 ); j <= max_k; j++ ) {
+		if( upper[j] < INF && (best == 0 || upper[j] < upper[best]) ) best = j;
+	}
+	if( best > 0 ) tree = trees[best];
+	return best;
+}
+
+/* vim: set noet ts=4 sw=4: */
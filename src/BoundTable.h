@@ -0,0 +1,53 @@
+#ifndef __BOUND_TABLE__H__
+#define __BOUND_TABLE__H__
+
+#include <mutex>
+#include <vector>
+
+#include "Solution.h"
+
+using namespace std;
+
+/**
+ * Best known bounds and trees for k = 1..max_k on one instance, shared by
+ * concurrent solves. With non-negative weights the optimum does not
+ * decrease with k (removing a leaf never makes a tree heavier), so an upper
+ * bound for k is one for all smaller k and a lower bound for k is one for
+ * all larger k. With negative weights the bounds of each k stand alone.
+ */
+class BoundTable
+{
+
+public:
+
+	// monotone: all weights are non-negative, bounds carry over to other k
+	BoundTable( int _max_k, bool _monotone = true );
+
+	// record a tree found for k, returns true if it improved on the best
+	bool offerTree( int k, const Solution& tree );
+	// record a lower bound proven for k
+	void offerLowerBound( int k, double bound );
+
+	// best upper bound for k implied by the trees of all k' >= k
+	double upperBound( int k ) const;
+	// best lower bound for k implied by the bounds of all k' <= k
+	double lowerBound( int k ) const;
+	// best tree found for exactly k, false if there is none
+	bool tree( int k, Solution& tree ) const;
+	// lightest tree for any k' >= k, returns k' or 0 if there is none
+	int upperTree( int k, Solution& tree ) const;
+	bool isMonotone() const { return monotone; }
+
+private:
+
+	int max_k;
+	bool monotone;
+	mutable mutex lock;
+	vector<double> upper, lower;
+	vector<Solution> trees;
+
+};
+// BoundTable
+
+#endif //__BOUND_TABLE__H__
+/* vim: set noet ts=4 sw=4: */
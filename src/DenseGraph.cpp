@@ -0,0 +1,248 @@
+#include "DenseGraph.h"
+
+#include <limits>
+
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1
+#endif
+
+static const double INF = numeric_limits<double>::infinity();
+
+// per-batch working set of bestKTree(), roughly an L2 cache
+static const unsigned int BATCH_BYTES = 256 * 1024;
+
+// bestPrimKTree() uses the matrix if it has at most this many entries per
+// edge: a step of the vector kernel then costs about as much as the heap
+// updates of a step on the incidence lists
+static const double DENSE_ENTRIES_PER_EDGE = 64;
+
+bool DenseGraph::fits( unsigned int n_nodes )
+{
+	if( n_nodes < 2 ) return true;
+	const size_t n = n_nodes - 1;
+	return n * ((n + 3) & ~(size_t) 3) * sizeof( double ) <= MAX_BYTES;
+}
+
+template <class Instance>
+DenseGraph::DenseGraph( const Instance& instance ) :
+	n( instance.n_nodes - 1 ), stride( (instance.n_nodes - 1 + 3) & ~3u ),
+	dist( (size_t) (instance.n_nodes - 1) * ((instance.n_nodes - 1 + 3) & ~3u), INF )
+{
+	for( unsigned int i = 0; i < instance.n_edges; i++ ) {
+		const typename Instance::Edge& e = instance.edges[i];
+		if( e.v1 == 0 || e.v2 == 0 || instance.removed[i] ) continue;
+		double& w1 = dist[(size_t) (e.v1 - 1) * stride + e.v2 - 1];
+		double& w2 = dist[(size_t) (e.v2 - 1) * stride + e.v1 - 1];
+		if( e.weight < w1 ) w1 = w2 = e.weight;
+	}
+}
+
+/* key = max(min(key, row), blocked); returns the smallest resulting key. */
+static double relaxScalar( const double *row, double *key, const double *blocked, unsigned int stride )
+{
+	double best = INF;
+	for( unsigned int v = 0; v < stride; v++ ) {
+		double k = (row[v] < key[v]) ? row[v] : key[v];
+		if( blocked[v] > k ) k = blocked[v];
+		key[v] = k;
+		if( k < best ) best = k;
+	}
+	return best;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__(( target( "avx2" ) ))
+static double relaxAVX2( const double *row, double *key, const double *blocked, unsigned int stride )
+{
+	__m256d best = _mm256_set1_pd( INF );
+	for( unsigned int v = 0; v < stride; v += 4 ) {
+		__m256d k = _mm256_loadu_pd( key + v );
+		k = _mm256_min_pd( k, _mm256_loadu_pd( row + v ) );
+		k = _mm256_max_pd( k, _mm256_loadu_pd( blocked + v ) );
+		_mm256_storeu_pd( key + v, k );
+		best = _mm256_min_pd( best, k );
+	}
+	__m128d m = _mm_min_pd( _mm256_castpd256_pd128( best ), _mm256_extractf128_pd( best, 1 ) );
+	m = _mm_min_sd( m, _mm_unpackhi_pd( m, m ) );
+	return _mm_cvtsd_f64( m );
+}
+#endif
+
+static bool haveAVX2()
+{
+#ifdef HAVE_AVX2_KERNEL
+	static const bool avx2 = __builtin_cpu_supports( "avx2" );
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+void DenseGraph::init( Run& run, unsigned int start ) const
+{
+	for( unsigned int v = 0; v < stride; v++ ) {
+		run.key[v] = INF;
+		run.blocked[v] = (v < n) ? 0 : INF;
+	}
+	run.blocked[start] = INF;
+	run.last = start;
+	run.size = 1;
+	run.weight = 0;
+}
+
+bool DenseGraph::step( Run& run, bool use_avx2 ) const
+{
+	const double *row = &dist[(size_t) run.last * stride];
+	double best;
+#ifdef HAVE_AVX2_KERNEL
+	if( use_avx2 ) best = relaxAVX2( row, run.key, run.blocked, stride );
+	else
+#endif
+	best = relaxScalar( row, run.key, run.blocked, stride );
+	(void) use_avx2;
+
+	if( best == INF ) return false;
+	unsigned int v = 0;
+	while( run.key[v] != best ) v++;
+
+	run.blocked[v] = INF;
+	run.key[v] = INF;
+	run.last = v;
+	run.size++;
+	run.weight += best;
+	return true;
+}
+
+double DenseGraph::kTree( unsigned int start, unsigned int k, vector<unsigned int> *nodes ) const
+{
+	vector<double> state( 2 * stride );
+	Run run = { &state[0], &state[stride], 0, 0, 0 };
+	const bool use_avx2 = haveAVX2();
+
+	init( run, start - 1 );
+	while( run.size < k ) {
+		if( !step( run, use_avx2 ) ) return INF;
+	}
+
+	if( nodes ) {
+		nodes->clear();
+		for( unsigned int v = 0; v < n; v++ ) {
+			if( run.blocked[v] == INF ) nodes->push_back( v + 1 );
+		}
+	}
+	return run.weight;
+}
+
+double DenseGraph::bestKTree( unsigned int k, unsigned int *start ) const
+{
+	/* Runs for a batch of starts advance in lock step, so that their state
+	 * stays in cache and rows picked by several runs are reused. */
+	const unsigned int batch = max( 1u, (unsigned int) (BATCH_BYTES / (2 * stride * sizeof( double ))) );
+	const bool use_avx2 = haveAVX2();
+
+	vector<double> state( (size_t) 2 * stride * batch );
+	vector<Run> runs( batch );
+	vector<bool> alive( batch );
+
+	double best = INF;
+	for( unsigned int first = 0; first < n; first += batch ) {
+		const unsigned int size = min( batch, n - first );
+		for( unsigned int j = 0; j < size; j++ ) {
+			double *s = &state[(size_t) 2 * stride * j];
+			Run run = { s, s + stride, 0, 0, 0 };
+			runs[j] = run;
+			init( runs[j], first + j );
+			alive[j] = true;
+		}
+
+		for( unsigned int i = 1; i < k; i++ ) {
+			for( unsigned int j = 0; j < size; j++ ) {
+				// runs that cannot beat the best tree so far are dropped
+				if( alive[j] ) alive[j] = step( runs[j], use_avx2 ) && runs[j].weight < best;
+			}
+		}
+
+		for( unsigned int j = 0; j < size; j++ ) {
+			if( alive[j] && runs[j].weight < best ) {
+				best = runs[j].weight;
+				if( start ) *start = first + j + 1;
+			}
+		}
+	}
+	return best;
+}
+
+/* Prim from every start node on the incidence lists with a binary heap; a
+ * run is dropped once it cannot beat the best tree so far. */
+template <class Instance>
+static double sparseBestKTree( const Instance& instance, unsigned int k, vector<unsigned int>& nodes )
+{
+	typedef pair<double, unsigned int> Candidate;
+	const greater<Candidate> lighter;
+
+	vector<bool> in_tree( instance.n_nodes, false );
+	vector<unsigned int> tree;
+	vector<Candidate> heap;
+	double best = INF;
+	for( unsigned int start = 1; start < instance.n_nodes; start++ ) {
+		tree.assign( 1, start );
+		in_tree[start] = true;
+		heap.clear();
+		double weight = 0;
+		unsigned int last = start;
+		while( tree.size() < k ) {
+			for( auto& e : instance.incidentEdges[last] ) {
+				const typename Instance::Edge& f = instance.edges[e];
+				const unsigned int u = (f.v1 == last) ? f.v2 : f.v1;
+				if( u == 0 || in_tree[u] ) continue;
+				heap.push_back( Candidate( f.weight, u ) );
+				push_heap( heap.begin(), heap.end(), lighter );
+			}
+			while( !heap.empty() && in_tree[heap.front().second] ) {
+				pop_heap( heap.begin(), heap.end(), lighter );
+				heap.pop_back();
+			}
+			if( heap.empty() || weight + heap.front().first >= best ) break;
+
+			weight += heap.front().first;
+			last = heap.front().second;
+			pop_heap( heap.begin(), heap.end(), lighter );
+			heap.pop_back();
+			in_tree[last] = true;
+			tree.push_back( last );
+		}
+
+		if( tree.size() == k && weight < best ) {
+			best = weight;
+			nodes = tree;
+		}
+		for( auto& v : tree ) in_tree[v] = false;
+	}
+	return best;
+}
+
+template <class Instance>
+double bestPrimKTree( const Instance& instance, unsigned int k, vector<unsigned int>& nodes )
+{
+	const double n = instance.n_nodes - 1;
+	// edges between instance nodes, the root edges are n_nodes - 1 of them
+	const double m = max( 1.0, (double) instance.n_edges - n );
+	if( !DenseGraph::fits( instance.n_nodes ) || n * n > DENSE_ENTRIES_PER_EDGE * m ) {
+		return sparseBestKTree( instance, k, nodes );
+	}
+
+	const DenseGraph graph( instance );
+	unsigned int start;
+	const double weight = graph.bestKTree( k, &start );
+	if( weight < INF ) graph.kTree( start, k, &nodes );
+	return weight;
+}
+
+#define INSTANTIATE( Index, Weight ) \
+	template DenseGraph::DenseGraph( const BasicInstance<Index, Weight>& ); \
+	template double bestPrimKTree( const BasicInstance<Index, Weight>&, unsigned int, vector<unsigned int>& );
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
+/* vim: set noet ts=4 sw=4: */
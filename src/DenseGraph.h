@@ -0,0 +1,70 @@
+#ifndef __DENSE_GRAPH__H__
+#define __DENSE_GRAPH__H__
+
+#include "Instance.h"
+#include "Tools.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * Distance matrix of an instance without the artificial root 0, with a
+ * Prim-style kernel growing minimum k-trees on it. Instance node v is row
+ * v - 1; rows are padded to a multiple of four so that the key update and
+ * min-reduction run on whole AVX2 vectors (with a scalar fallback on CPUs
+ * without AVX2).
+ */
+class DenseGraph
+{
+
+public:
+
+	// instances whose matrix (n^2 doubles) would be larger are not converted
+	static const size_t MAX_BYTES = 64 << 20;
+
+	// true if the matrix of an instance with n_nodes nodes fits into MAX_BYTES
+	static bool fits( unsigned int n_nodes );
+
+	// number of nodes (without the artificial root) and padded row length
+	unsigned int n, stride;
+	// row-major weights, +inf for missing edges, the diagonal and padding
+	vector<double> dist;
+
+	template <class Instance>
+	DenseGraph( const Instance& instance );
+
+	// weight of a minimum k-tree grown by Prim from start (an instance node),
+	// +inf if the component of start has less than k nodes; the instance
+	// nodes of the tree are stored in nodes if given
+	double kTree( unsigned int start, unsigned int k, vector<unsigned int> *nodes = 0 ) const;
+	// best kTree() over all start nodes, computed in cache-sized batches of
+	// starts; the best start is stored in start if given
+	double bestKTree( unsigned int k, unsigned int *start = 0 ) const;
+
+private:
+
+	// state of one Prim run: distance of each node to the tree and +inf
+	// for nodes already in the tree (0 otherwise)
+	struct Run
+	{
+		double *key, *blocked;
+		unsigned int last, size;
+		double weight;
+	};
+
+	void init( Run& run, unsigned int start ) const;
+	// adds the node closest to the tree, returns false if there is none
+	bool step( Run& run, bool use_avx2 ) const;
+
+};
+// DenseGraph
+
+/* Best Prim k-tree over all start nodes: on a DenseGraph if its matrix fits
+ * and the instance is dense enough for the vector kernel to pay off, on the
+ * incidence lists otherwise. Returns its weight, +inf if there is none, and
+ * stores its instance nodes. */
+template <class Instance>
+double bestPrimKTree( const Instance& instance, unsigned int k, vector<unsigned int>& nodes );
+
+#endif //__DENSE_GRAPH__H__
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,216 @@
+#ifndef __GENERATOR__CPP__
+#define __GENERATOR__CPP__
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Writes synthetic instances in the format of the instances in data/: node 0 is the
+ * artificial root connected to every other node by an edge of weight 0.
+ * Instances are reproducible from family, size, seed and weight range.
+ */
+
+struct Edge
+{
+	unsigned int v1, v2;
+	long weight;
+};
+
+void usage()
+{
+	cout << "USAGE:\t<program> -t family -n nodes [-m edges] [-s seed] [-w max weight] -o file\n";
+	cout << "FAMILIES:\n";
+	cout << "\tgeometric\trandom geometric graph in the unit square with about m edges\n";
+	cout << "\tgrid, torus\tsqrt(n) x sqrt(n) grid, with wrap-around for torus\n";
+	cout << "\tpowerlaw\tpreferential attachment with about m edges\n";
+	cout << "\tcomplete\tall n(n-1)/2 edges\n";
+	cout << "EXAMPLE:\t" << "./kmst-gen -t geometric -n 1000 -m 10000 -s 1 -o data/geo-1000.dat\n\n";
+	exit( 1 );
+} // usage
+
+/* Euclidean weights scaled to [1, max_weight] over the connection radius. */
+static void geometric( unsigned int n, unsigned long m, long max_weight, mt19937_64& rng, vector<Edge>& edges )
+{
+	uniform_real_distribution<double> coordinate( 0, 1 );
+	vector<double> x( n + 1 ), y( n + 1 );
+	for( unsigned int v = 1; v <= n; v++ ) {
+		x[v] = coordinate( rng );
+		y[v] = coordinate( rng );
+	}
+
+	/* Expected number of pairs within radius r is about n^2 / 2 * pi r^2. */
+	const double r = min( sqrt( 2.0 * m / (acos( -1.0 ) * n * (double) n) ), sqrt( 2.0 ) );
+
+	/* Bucket points into cells of size r and compare neighbouring cells only. */
+	const unsigned int cells = max( 1u, (unsigned int) (1 / r) );
+	vector<vector<unsigned int> > grid( cells * cells );
+	for( unsigned int v = 1; v <= n; v++ ) {
+		const unsigned int cx = min( cells - 1, (unsigned int) (x[v] * cells) );
+		const unsigned int cy = min( cells - 1, (unsigned int) (y[v] * cells) );
+		grid[cy * cells + cx].push_back( v );
+	}
+	for( unsigned int cy = 0; cy < cells; cy++ ) {
+		for( unsigned int cx = 0; cx < cells; cx++ ) {
+			for( auto& v : grid[cy * cells + cx] ) {
+				for( unsigned int dy = 0; dy < 2 && cy + dy < cells; dy++ ) {
+					for( int dx = (dy == 0) ? 0 : -1; dx <= 1; dx++ ) {
+						if( (int) cx + dx < 0 || cx + dx >= cells ) continue;
+						for( auto& u : grid[(cy + dy) * cells + cx + dx] ) {
+							if( dy == 0 && dx == 0 && u <= v ) continue;
+							const double d = hypot( x[v] - x[u], y[v] - y[u] );
+							if( d >= r ) continue;
+							Edge e = { min( u, v ), max( u, v ), 1 + (long) (d / r * (max_weight - 1)) };
+							edges.push_back( e );
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+static void grid( unsigned int n, bool torus, long max_weight, mt19937_64& rng, vector<Edge>& edges )
+{
+	uniform_int_distribution<long> weight( 1, max_weight );
+	const unsigned int side = max( 2u, (unsigned int) sqrt( (double) n ) );
+	for( unsigned int row = 0; row < side; row++ ) {
+		for( unsigned int col = 0; col < side; col++ ) {
+			const unsigned int v = row * side + col + 1;
+			if( col + 1 < side || (torus && side > 2) ) {
+				Edge e = { v, row * side + (col + 1) % side + 1, weight( rng ) };
+				edges.push_back( e );
+			}
+			if( row + 1 < side || (torus && side > 2) ) {
+				Edge e = { v, ((row + 1) % side) * side + col + 1, weight( rng ) };
+				edges.push_back( e );
+			}
+		}
+	}
+}
+
+/* Barabasi-Albert: every new node attaches to about m / n existing nodes
+ * chosen proportionally to their degree. */
+static void powerlaw( unsigned int n, unsigned long m, long max_weight, mt19937_64& rng, vector<Edge>& edges )
+{
+	uniform_int_distribution<long> weight( 1, max_weight );
+	const unsigned int degree = max( 1u, (unsigned int) (m / n) );
+
+	// every node appears once per incident edge
+	vector<unsigned int> endpoints;
+	for( unsigned int v = 1; v <= n; v++ ) {
+		vector<unsigned int> targets;
+		if( v <= degree + 1 ) {
+			for( unsigned int u = 1; u < v; u++ ) targets.push_back( u );
+		} else {
+			uniform_int_distribution<size_t> pick( 0, endpoints.size() - 1 );
+			for( unsigned int tries = 0; targets.size() < degree && tries < 10 * degree; tries++ ) {
+				const unsigned int u = endpoints[pick( rng )];
+				if( find( targets.begin(), targets.end(), u ) == targets.end() ) targets.push_back( u );
+			}
+		}
+		for( auto& u : targets ) {
+			Edge e = { u, v, weight( rng ) };
+			edges.push_back( e );
+			endpoints.push_back( u );
+			endpoints.push_back( v );
+		}
+	}
+}
+
+static void complete( unsigned int n, long max_weight, mt19937_64& rng, vector<Edge>& edges )
+{
+	uniform_int_distribution<long> weight( 1, max_weight );
+	for( unsigned int v = 1; v <= n; v++ ) {
+		for( unsigned int u = v + 1; u <= n; u++ ) {
+			Edge e = { v, u, weight( rng ) };
+			edges.push_back( e );
+		}
+	}
+}
+
+int main( int argc, char *argv[] )
+{
+	string family;
+	string file;
+	unsigned int n = 0;
+	unsigned long m = 0;
+	unsigned long seed = 1;
+	long max_weight = 1000;
+
+	int opt;
+	while( (opt = getopt( argc, argv, "t:n:m:s:w:o:" )) != EOF ) {
+		switch( opt ) {
+			case 't': // graph family
+				family = optarg;
+				break;
+			case 'n': // nodes without the artificial root
+				n = atoi( optarg );
+				break;
+			case 'm': // approximate number of edges
+				m = atol( optarg );
+				break;
+			case 's': // random seed
+				seed = atol( optarg );
+				break;
+			case 'w': // largest edge weight
+				max_weight = atol( optarg );
+				break;
+			case 'o': // output file
+				file = optarg;
+				break;
+			default:
+				usage();
+				break;
+		}
+	}
+	if( n < 2 || file.empty() || max_weight < 1 ) usage();
+	if( m == 0 ) m = 10 * (unsigned long) n;
+
+	mt19937_64 rng( seed );
+	vector<Edge> edges;
+	if( family == "geometric" ) geometric( n, m, max_weight, rng, edges );
+	else if( family == "grid" ) grid( n, false, max_weight, rng, edges );
+	else if( family == "torus" ) grid( n, true, max_weight, rng, edges );
+	else if( family == "powerlaw" ) powerlaw( n, m, max_weight, rng, edges );
+	else if( family == "complete" ) complete( n, max_weight, rng, edges );
+	else usage();
+
+	// grids are rounded down to a square
+	if( family == "grid" || family == "torus" ) {
+		const unsigned int side = max( 2u, (unsigned int) sqrt( (double) n ) );
+		n = side * side;
+	}
+
+	ofstream ofs( file.c_str() );
+	if( ofs.fail() ) {
+		cerr << "could not open output file " << file << "\n";
+		exit( -1 );
+	}
+
+	ofs << n + 1 << "\n" << n + edges.size() << "\n";
+	unsigned long id = 0;
+	for( unsigned int v = 1; v <= n; v++ ) {
+		ofs << id++ << " 0 " << v << " 0 \n";
+	}
+	for( auto& e : edges ) {
+		ofs << id++ << " " << e.v1 << " " << e.v2 << " " << e.weight << " \n";
+	}
+	ofs.close();
+
+	cout << "Wrote " << family << " instance with " << n + 1 << " nodes and "
+		<< n + edges.size() << " edges to " << file << "\n";
+	return 0;
+} // main
+
+#endif // __GENERATOR__CPP__
+
+/* vim: set noet ts=4 sw=4: */
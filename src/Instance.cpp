@@ -1,6 +1,21 @@
 #include "Instance.h"
 
-Instance::Instance( string file ) :
+#include <cmath>
+#include <limits>
+
+// true if weight is exactly representable as Weight, which InstanceFormat
+// chose from the instance file alone
+template <typename Weight>
+static bool representable( double weight )
+{
+	if( !numeric_limits<Weight>::is_integer ) return true;
+	// -min() is max() + 1 and exact as a double, unlike max()
+	const double min = (double) numeric_limits<Weight>::min();
+	return weight == floor( weight ) && weight >= min && weight < -min;
+}
+
+template <typename Index, typename Weight>
+BasicInstance<Index, Weight>::BasicInstance( string file, bool verbose ) :
 	n_nodes( 0 ), n_edges( 0 )
 {
 	ifstream ifs( file.c_str() );
@@ -17,6 +32,7 @@ Instance::Instance( string file ) :
 
 	edges.resize( n_edges );
 	incidentEdges.resize( n_nodes );
+	removed.assign( n_edges, false );
 
 	unsigned int id;
 	while( ifs >> id ) {
@@ -26,6 +42,7 @@ Instance::Instance( string file ) :
 	}
 	ifs.close();
 
+	if( !verbose ) return;
 	cout << "Incidency list:" << "\n";
 	for( unsigned int v = 0; v < n_nodes; v++ ) {
 		cout << v << ": ";
@@ -35,4 +52,144 @@ Instance::Instance( string file ) :
 		cout << "\n";
 	}
 }
+
+template <typename Index, typename Weight>
+unsigned int BasicInstance<Index, Weight>::apply( const vector<EdgeDelta>& delta )
+{
+	unsigned int applied = 0;
+	for( auto& d : delta ) {
+		if( d.kind == EdgeDelta::ADD ) {
+			if( d.v1 == 0 || d.v2 == 0 || d.v1 >= n_nodes || d.v2 >= n_nodes || d.v1 == d.v2 ) {
+				cerr << "Instance: cannot add edge (" << d.v1 << "," << d.v2 << ")\n";
+				continue;
+			}
+			if( !representable<Weight>( d.weight ) ) {
+				cerr << "Instance: weight " << d.weight << " of edge (" << d.v1 << "," << d.v2
+					<< ") does not fit the weights of the instance\n";
+				continue;
+			}
+			// weights are converted to the weight type of the instance
+			Edge e = { (Index) d.v1, (Index) d.v2, (Weight) d.weight };
+			edges.push_back( e );
+			removed.push_back( false );
+			incidentEdges[d.v1].push_back( n_edges );
+			incidentEdges[d.v2].push_back( n_edges );
+			n_edges++;
+		} else {
+			if( d.edge >= n_edges || removed[d.edge] ) {
+				cerr << "Instance: no edge " << d.edge << "\n";
+				continue;
+			}
+			if( d.kind == EdgeDelta::WEIGHT && !representable<Weight>( d.weight ) ) {
+				cerr << "Instance: weight " << d.weight << " of edge " << d.edge
+					<< " does not fit the weights of the instance\n";
+				continue;
+			}
+			Edge& e = edges[d.edge];
+			if( d.kind == EdgeDelta::WEIGHT ) {
+				e.weight = (Weight) d.weight;
+			} else {
+				removed[d.edge] = true;
+				incidentEdges[e.v1].remove( d.edge );
+				incidentEdges[e.v2].remove( d.edge );
+			}
+		}
+		applied++;
+	}
+	return applied;
+}
+
+template <typename Index, typename Weight>
+uint64_t BasicInstance<Index, Weight>::hash() const
+{
+	uint64_t h = 14695981039346656037ULL;
+	auto add = [&h]( const void *data, size_t size ) {
+		for( size_t i = 0; i < size; i++ ) {
+			h ^= ((const unsigned char *) data)[i];
+			h *= 1099511628211ULL;
+		}
+	};
+
+	// fixed widths, so that all instantiations agree
+	const uint32_t sizes[] = { n_nodes, n_edges };
+	add( sizes, sizeof( sizes ) );
+	for( unsigned int e = 0; e < n_edges; e++ ) {
+		const uint32_t ends[] = { edges[e].v1, edges[e].v2, removed[e] };
+		const double weight = edges[e].weight;
+		add( ends, sizeof( ends ) );
+		add( &weight, sizeof( weight ) );
+	}
+	return h;
+}
+
+bool readDelta( string file, vector<EdgeDelta>& delta )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open delta file " << file << "\n";
+		return false;
+	}
+
+	string line;
+	for( unsigned int number = 1; getline( ifs, line ); number++ ) {
+		istringstream iss( line );
+		string kind;
+		if( !(iss >> kind) || kind[0] == '#' ) continue;
+
+		EdgeDelta d = { EdgeDelta::WEIGHT, 0, 0, 0, 0 };
+		bool ok;
+		if( kind == "w" ) {
+			ok = (bool) (iss >> d.edge >> d.weight);
+		} else if( kind == "d" ) {
+			d.kind = EdgeDelta::REMOVE;
+			ok = (bool) (iss >> d.edge);
+		} else if( kind == "a" ) {
+			d.kind = EdgeDelta::ADD;
+			ok = (bool) (iss >> d.v1 >> d.v2 >> d.weight);
+		} else {
+			ok = false;
+		}
+		if( !ok ) {
+			cerr << file << ":" << number << ": invalid change \"" << line << "\"\n";
+			return false;
+		}
+		delta.push_back( d );
+	}
+	return true;
+}
+
+InstanceFormat::InstanceFormat( string file ) :
+	wide_index( true ), weight( INT32 )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open input file " << file << "\n";
+		exit( -1 );
+	}
+
+	unsigned int n_nodes, n_edges;
+	ifs >> n_nodes >> n_edges;
+	wide_index = n_nodes > (unsigned long) numeric_limits<uint16_t>::max() + 1;
+
+	/* Weights are read as text: anything that is not a plain integer needs
+	 * doubles, integers beyond 32 bit need 64 bit weights. */
+	unsigned long id, v1, v2;
+	string w;
+	while( ifs >> id >> v1 >> v2 >> w ) {
+		if( w.find_first_of( ".eE" ) != string::npos ) {
+			weight = DOUBLE;
+			break;
+		}
+		const long long value = atoll( w.c_str() );
+		if( value > numeric_limits<int32_t>::max() || value < numeric_limits<int32_t>::min() ) {
+			weight = INT64;
+		}
+	}
+	ifs.close();
+}
+
+#define INSTANTIATE( Index, Weight ) template class BasicInstance<Index, Weight>;
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
 /* vim: set noet ts=4 sw=4: */
@@ -7,18 +7,46 @@
 #include <list>
 #include <string>
 #include <fstream>
+#include <stdint.h>
 
 using namespace std;
 
-class Instance
+/* One change of a delta file, see readDelta(). */
+struct EdgeDelta
+{
+	enum Kind { WEIGHT, REMOVE, ADD };
+
+	Kind kind;
+	// changed or removed edge
+	unsigned int edge;
+	// endpoints of an added edge
+	unsigned int v1, v2;
+	// new weight of a changed or added edge
+	double weight;
+};
+
+// read changes from file, one per line: "w <edge> <weight>" changes a weight,
+// "d <edge>" removes an edge and "a <v1> <v2> <weight>" adds one
+bool readDelta( string file, vector<EdgeDelta>& delta );
+
+/**
+ * Graph container with compile-time node index and edge weight types, so that
+ * small instances use compact edges and large costs fit into 64 bit weights.
+ * Use InstanceFormat to pick the narrowest instantiation for a file.
+ */
+template <typename Index, typename Weight>
+class BasicInstance
 {
 
 public:
 
+	typedef Index index_type;
+	typedef Weight weight_type;
+
 	struct Edge
 	{
-		unsigned int v1, v2;
-		int weight;
+		Index v1, v2;
+		Weight weight;
 	};
 
 	// number of nodes and edges
@@ -27,12 +55,65 @@ public:
 	vector<Edge> edges;
 	// incident edges denoted by index in vector <edges>
 	vector<list<unsigned int> > incidentEdges;
+	// edges removed by apply(); they keep their index, but are no longer
+	// incident to their endpoints
+	vector<bool> removed;
+
+	// constructor, prints the incidence lists if verbose
+	BasicInstance( string file, bool verbose = true );
 
-	// constructor
-	Instance( string file );
+	// apply changed weights and removed edges in place and append added
+	// edges; changes with a weight that Weight cannot hold exactly are
+	// rejected. Returns the number of changes applied
+	unsigned int apply( const vector<EdgeDelta>& delta );
 
+	// FNV-1a hash of nodes, edges, weights and removed edges
+	uint64_t hash() const;
+
+};
+// BasicInstance
+
+/* All instantiated (index, weight) combinations. */
+#define KMST_INSTANCE_TYPES( X ) \
+	X( uint16_t, int32_t ) \
+	X( uint16_t, int64_t ) \
+	X( uint16_t, double ) \
+	X( uint32_t, int32_t ) \
+	X( uint32_t, int64_t ) \
+	X( uint32_t, double )
+
+// the representation of the original implementation
+typedef BasicInstance<uint32_t, int32_t> Instance;
+
+/**
+ * Index and weight width needed by an instance file, determined from its
+ * header and a scan of the weights.
+ */
+struct InstanceFormat
+{
+	enum WeightType { INT32, INT64, DOUBLE };
+
+	bool wide_index;
+	WeightType weight;
+
+	InstanceFormat( string file );
+
+	/* Calls f.template run<I>() for the narrowest instantiation I that can
+	 * represent this format and returns its result. */
+	template <class F>
+	int dispatch( F& f ) const
+	{
+		if( wide_index ) {
+			if( weight == INT32 ) return f.template run<BasicInstance<uint32_t, int32_t> >();
+			if( weight == INT64 ) return f.template run<BasicInstance<uint32_t, int64_t> >();
+			return f.template run<BasicInstance<uint32_t, double> >();
+		}
+		if( weight == INT32 ) return f.template run<BasicInstance<uint16_t, int32_t> >();
+		if( weight == INT64 ) return f.template run<BasicInstance<uint16_t, int64_t> >();
+		return f.template run<BasicInstance<uint16_t, double> >();
+	}
 };
-// Instance
+// InstanceFormat
 
 #endif //__INSTANCE__H__
 /* vim: set noet ts=4 sw=4: */
@@ -2,28 +2,167 @@
 #define __MAIN__CPP__
 
 #include <iostream>
+#include <getopt.h>
 
 #include "Instance.h"
+#include "PerfCounters.h"
 #include "Tools.h"
 #include "kMST_ILP.h"
+#include "kMST_Enum.h"
+#include "kMST_Batch.h"
 
 using namespace std;
 
 void usage()
 {
-	cout << "USAGE:\t<program> -f filename -m model [-k <nodes to connect>]\n";
+	cout << "USAGE:\t<program> -f filename -m model [-k <nodes to connect>] [options]\n";
+	cout << "MODELS:\tscf, mcf, mtz; lp:<model> or lp:all to only compare root bounds;\n";
+	cout << "\tauto: exact enumeration for k up to --auto-k if the instance is small\n";
+	cout << "\tor sparse enough, scf otherwise\n";
+	cout << "OPTIONS:\n";
+	cout << "\t--save-solution <file>\twrite the final tree to file\n";
+	cout << "\t--mip-start <file>\tuse the tree in file (repaired if necessary) as start\n";
+	cout << "\t--checkpoint <file>\twrite every new incumbent to file\n";
+	cout << "\t--print-variables\tprint non-zero variables of the final solution\n";
+	cout << "\t--incumbents <file>\tstream incumbents as JSON lines to file (- for stdout)\n";
+	cout << "\t--time-limit <sec>\tstop after the given wall-clock time\n";
+	cout << "\t--mem-limit <MB>\tuse node files beyond the given working memory\n";
+	cout << "\t--gap <gap>\t\tstop at the given relative MIP gap\n";
+	cout << "\t--node-file-dir <dir>\twrite compressed node files to dir\n";
+	cout << "\t--root-cuts\t\tin lp: mode, include CPLEX root cuts in the bound\n";
+	cout << "\t--prim-start\t\tuse the best Prim k-tree as start\n";
+	cout << "\t-q, --quiet\t\tdo not print the incidence lists of the instance\n";
+	cout << "\t--telemetry <file>\tsample bound, incumbent, gap, nodes and cuts into file\n";
+	cout << "\t--telemetry-interval <sec>\tseconds between samples (default 1)\n";
+	cout << "\t--mip-display <level>\tCPLEX node log detail, 0 for none (default 2)\n";
+	cout << "\t--mip-interval <n>\tCPLEX node log every n nodes (default 1)\n";
+	cout << "\t--delta <file>\t\tafter solving, apply the edge changes in file and\n";
+	cout << "\t\t\t\tsolve again from the previous solution (repeatable)\n";
+	cout << "\t--profile <file>\tuse the CPLEX parameters of a profile written by kmst-tune\n";
+	cout << "\t--model-cache <dir>\tload extracted models from dir, save them on a miss\n";
+	cout << "\t--auto-k <k>\t\tlargest k solved by enumeration in auto mode (default 15)\n";
+	cout << "\t--batch <k list>\tsolve all k in a list like 1-20,25 in parallel, sharing bounds\n";
+	cout << "\t--workers <n>\t\tconcurrent solves in batch mode (default: one per core)\n";
+	cout << "\t--perf-counters\t\treport wall time and hardware counters per phase\n";
+	cout << "\t--branching <mode>\tpriorities: root arcs, then nodes, then arcs;\n";
+	cout << "\t\t\t\tcallback: also choose nodes by LP value and score\n";
 	cout << "EXAMPLE:\t" << "./kmst -f data/g01.dat -m scf -k 5\n\n";
 	exit( 1 );
 } // usage
 
+/* Reads and solves an instance, for use with InstanceFormat::dispatch(). */
+struct Run
+{
+	string file;
+	string model_type;
+	int k;
+	int auto_k;
+	bool quiet;
+	kMST_ILP_Base::Options options;
+	// delta files applied one after the other, each followed by a re-solve
+	vector<string> deltas;
+	// k values of batch mode instead of k, and its number of workers
+	vector<int> batch;
+	int workers;
+
+	Run( string _file, string _model_type, int _k, int _auto_k, bool _quiet, const kMST_ILP_Base::Options& _options,
+			const vector<string>& _deltas, const vector<int>& _batch, int _workers ) :
+		file( _file ), model_type( _model_type ), k( _k ), auto_k( _auto_k ), quiet( _quiet ), options( _options ),
+		deltas( _deltas ), batch( _batch ), workers( _workers ) { }
+
+	template <class Instance>
+	Instance parse()
+	{
+		PerfCounters::Scope scope( "parse" );
+		return Instance( file, !quiet );
+	}
+
+	template <class Instance>
+	int run()
+	{
+		// read instance
+		const double start = Tools::CPUtime();
+		Instance instance = parse<Instance>();
+		cout << "Load time: " << Tools::CPUtime() - start << "\n";
+
+		if( !batch.empty() ) {
+			if( !deltas.empty() ) cerr << "ignoring delta files in batch mode\n";
+			return kMST_Batch<Instance>( instance, model_type == "auto" ? "scf" : model_type, batch, workers, options ).solve();
+		}
+
+		// small k do not need CPLEX
+		string type = model_type;
+		if( type == "auto" ) {
+			if( kMST_Enum<Instance>::suitable( instance, k, auto_k ) ) {
+				int status = kMST_Enum<Instance>( instance, k, options.save_solution ).solve();
+				for( auto& file : deltas ) {
+					vector<EdgeDelta> delta;
+					if( !readDelta( file, delta ) ) return status;
+					cout << "Applied " << instance.apply( delta ) << " changes of " << file << "\n";
+					status = kMST_Enum<Instance>( instance, k, options.save_solution ).solve();
+				}
+				if( PerfCounters::enabled() ) PerfCounters::report( cout );
+				return status;
+			}
+			type = "scf";
+		}
+
+		// solve instance
+		kMST_ILP<Instance> ilp( instance, type, k, options );
+		int status = ilp.solve();
+		for( auto& file : deltas ) {
+			vector<EdgeDelta> delta;
+			if( !readDelta( file, delta ) ) return status;
+			cout << "Applying " << delta.size() << " changes of " << file << "\n";
+			status = ilp.update( delta );
+		}
+		return status;
+	}
+}; // Run
+
 int main( int argc, char *argv[] )
 {
 	string file( "data/g01.dat" );
 	string model_type( "flow" );
 
+	kMST_ILP_Base::Options options;
+
+	static const struct option long_options[] = {
+		{ "save-solution", required_argument, 0, 'S' },
+		{ "mip-start", required_argument, 0, 'W' },
+		{ "checkpoint", required_argument, 0, 'C' },
+		{ "print-variables", no_argument, 0, 'p' },
+		{ "incumbents", required_argument, 0, 'I' },
+		{ "time-limit", required_argument, 0, 'T' },
+		{ "mem-limit", required_argument, 0, 'M' },
+		{ "gap", required_argument, 0, 'G' },
+		{ "node-file-dir", required_argument, 0, 'N' },
+		{ "root-cuts", no_argument, 0, 'R' },
+		{ "prim-start", no_argument, 0, 'P' },
+		{ "quiet", no_argument, 0, 'q' },
+		{ "telemetry", required_argument, 0, 'Y' },
+		{ "telemetry-interval", required_argument, 0, 'y' },
+		{ "mip-display", required_argument, 0, 'D' },
+		{ "mip-interval", required_argument, 0, 'L' },
+		{ "branching", required_argument, 0, 'B' },
+		{ "auto-k", required_argument, 0, 'A' },
+		{ "delta", required_argument, 0, 'd' },
+		{ "model-cache", required_argument, 0, 'X' },
+		{ "profile", required_argument, 0, 'O' },
+		{ "perf-counters", no_argument, 0, 'H' },
+		{ "batch", required_argument, 0, 'b' },
+		{ "workers", required_argument, 0, 'w' },
+		{ 0, 0, 0, 0 }
+	};
+
 	int opt;
 	int k = 5;
-	while( (opt = getopt( argc, argv, "f:m:k:" )) != EOF ) {
+	int auto_k = 15;
+	bool quiet = false;
+	vector<string> deltas;
+	vector<int> batch;
+	int workers = 0;
+	while( (opt = getopt_long( argc, argv, "f:m:k:pq", long_options, 0 )) != EOF ) {
 		switch( opt ) {
 			case 'f': // instance file
 				file = optarg;
@@ -34,20 +173,90 @@ int main( int argc, char *argv[] )
 			case 'k': // nodes to connect
 				k = atoi( optarg );
 				break;
+			case 'S': // write final solution
+				options.save_solution = optarg;
+				break;
+			case 'W': // warm start
+				options.mip_start = optarg;
+				break;
+			case 'C': // write incumbents
+				options.checkpoint = optarg;
+				break;
+			case 'p': // print variables
+				options.print_variables = true;
+				break;
+			case 'I': // incumbent stream
+				options.incumbents = optarg;
+				break;
+			case 'T': // time limit
+				options.time_limit = atof( optarg );
+				break;
+			case 'M': // memory limit
+				options.mem_limit = atof( optarg );
+				break;
+			case 'G': // relative MIP gap
+				options.gap = atof( optarg );
+				break;
+			case 'N': // node file directory
+				options.node_file_dir = optarg;
+				break;
+			case 'R': // root cuts in lp: mode
+				options.root_cuts = true;
+				break;
+			case 'P': // Prim k-tree start
+				options.prim_start = true;
+				break;
+			case 'q': // do not print incidence lists
+				quiet = true;
+				break;
+			case 'Y': // progress time series
+				options.telemetry = optarg;
+				break;
+			case 'y': // seconds between progress samples
+				options.telemetry_interval = atof( optarg );
+				break;
+			case 'D': // node log detail
+				options.mip_display = atoi( optarg );
+				break;
+			case 'L': // node log frequency
+				options.mip_interval = atoi( optarg );
+				break;
+			case 'B': // branching priorities and callback
+				options.branching = optarg;
+				break;
+			case 'A': // enumeration threshold of auto mode
+				auto_k = atoi( optarg );
+				break;
+			case 'd': // changes to apply after solving
+				deltas.push_back( optarg );
+				break;
+			case 'X': // directory of cached models
+				options.model_cache = optarg;
+				break;
+			case 'O': // tuned CPLEX parameters
+				if( !options.profile.read( optarg ) ) exit( -1 );
+				break;
+			case 'H': // per-phase performance counters
+				PerfCounters::enable();
+				break;
+			case 'b': // solve many k in parallel
+				if( !parseKList( optarg, batch ) ) {
+					cerr << "invalid k list " << optarg << "\n";
+					usage();
+				}
+				break;
+			case 'w': // concurrent solves in batch mode
+				workers = atoi( optarg );
+				break;
 			default:
 				usage();
 				break;
 		}
 	}
 
-	// read instance
-	Instance instance( file );
-
-	// solve instance
-	kMST_ILP ilp( instance, model_type, k );
-	ilp.solve();
-
-	return 0;
+	// read and solve instance in the narrowest representation that fits
+	Run run( file, model_type, k, auto_k, quiet, options, deltas, batch, workers );
+	return InstanceFormat( file ).dispatch( run );
 } // main
 
 #endif // __MAIN__CPP__
@@ -0,0 +1,161 @@
+#include "PerfCounters.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace PerfCounters;
+
+// counts of an event that could not be opened
+static const uint64_t MISSING = ~(uint64_t) 0;
+
+struct Phase
+{
+	string name;
+	unsigned long calls;
+	double wall;
+	uint64_t counts[N_EVENTS];
+};
+
+static atomic<bool> active( false );
+static mutex phases_mutex;
+static vector<Phase> phases;
+
+/* File descriptors of the counters of one thread, -1 if unavailable. */
+struct Counters
+{
+	int fds[N_EVENTS];
+
+	Counters()
+	{
+		static const struct { uint32_t type; uint64_t config; } events[N_EVENTS] = {
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+			{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+		};
+
+		for( int e = 0; e < N_EVENTS; e++ ) {
+			perf_event_attr attr;
+			memset( &attr, 0, sizeof( attr ) );
+			attr.size = sizeof( attr );
+			attr.type = events[e].type;
+			attr.config = events[e].config;
+			attr.inherit = 1;
+			// user space only, allowed without privileges
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			// calling thread on any CPU
+			fds[e] = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+
+			static atomic<bool> warned( false );
+			if( fds[e] < 0 && !warned.exchange( true ) ) {
+				cerr << "PerfCounters: some counters are not available: " << strerror( errno ) << "\n";
+			}
+		}
+	}
+
+	~Counters()
+	{
+		for( auto& fd : fds ) if( fd >= 0 ) close( fd );
+	}
+
+	void read( uint64_t *counts ) const
+	{
+		for( int e = 0; e < N_EVENTS; e++ ) {
+			if( fds[e] < 0 || ::read( fds[e], &counts[e], sizeof( uint64_t ) ) != sizeof( uint64_t ) ) {
+				counts[e] = MISSING;
+			}
+		}
+	}
+};
+
+static const Counters& threadCounters()
+{
+	static thread_local Counters counters;
+	return counters;
+}
+
+void PerfCounters::enable()
+{
+	active = true;
+}
+
+bool PerfCounters::enabled()
+{
+	return active;
+}
+
+PerfCounters::Scope::Scope( const char *_phase ) :
+	phase( _phase )
+{
+	if( !active ) return;
+	threadCounters().read( counts );
+	start = chrono::steady_clock::now();
+}
+
+PerfCounters::Scope::~Scope()
+{
+	if( !active ) return;
+	const auto end = chrono::steady_clock::now();
+	uint64_t now[N_EVENTS];
+	threadCounters().read( now );
+
+	lock_guard<mutex> guard( phases_mutex );
+	Phase *p = 0;
+	for( auto& q : phases ) if( q.name == phase ) p = &q;
+	if( !p ) {
+		phases.push_back( Phase() );
+		p = &phases.back();
+		p->name = phase;
+		p->calls = 0;
+		p->wall = 0;
+		for( auto& c : p->counts ) c = 0;
+	}
+
+	p->calls++;
+	p->wall += chrono::duration<double>( end - start ).count();
+	for( int e = 0; e < N_EVENTS; e++ ) {
+		if( now[e] == MISSING || counts[e] == MISSING ) p->counts[e] = MISSING;
+		else if( p->counts[e] != MISSING ) p->counts[e] += now[e] - counts[e];
+	}
+}
+
+void PerfCounters::report( ostream& out )
+{
+	static const char *names[N_EVENTS] = { "cycles", "instructions", "cache-miss", "branch-miss", "page-faults" };
+
+	lock_guard<mutex> guard( phases_mutex );
+	size_t width = 5;
+	for( auto& p : phases ) width = max( width, p.name.size() );
+
+	out << "Performance counters:\n";
+	out << left << setw( width ) << "phase" << right << setw( 7 ) << "calls" << setw( 12 ) << "wall ms";
+	for( auto& name : names ) out << setw( 15 ) << name;
+	out << setw( 7 ) << "IPC" << "\n";
+	for( auto& p : phases ) {
+		out << left << setw( width ) << p.name << right << setw( 7 ) << p.calls
+			<< setw( 12 ) << fixed << setprecision( 3 ) << p.wall * 1000;
+		for( auto& c : p.counts ) {
+			if( c == MISSING ) out << setw( 15 ) << "-";
+			else out << setw( 15 ) << c;
+		}
+		if( p.counts[CYCLES] == MISSING || p.counts[INSTRUCTIONS] == MISSING || p.counts[CYCLES] == 0 ) {
+			out << setw( 7 ) << "-";
+		} else {
+			out << setw( 7 ) << setprecision( 2 ) << (double) p.counts[INSTRUCTIONS] / p.counts[CYCLES];
+		}
+		out << "\n";
+	}
+	out << defaultfloat << setprecision( 6 ) << "\n";
+}
+
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,46 @@
+#ifndef __PERF_COUNTERS__H__
+#define __PERF_COUNTERS__H__
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * Wall time and hardware counters (cycles, instructions, cache misses,
+ * branch misses, page faults) per phase of a run, via perf_event_open.
+ * A Scope measures the enclosing block and adds it to its phase; nested
+ * phases are also counted in the outer ones. Counters are opened for each
+ * measuring thread and inherited by threads it starts, whose counts are
+ * added when they exit. Nothing is measured unless enable() was called.
+ */
+namespace PerfCounters
+{
+	enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, PAGE_FAULTS, N_EVENTS };
+
+	// start measuring Scopes of all threads
+	void enable();
+	bool enabled();
+
+	class Scope
+	{
+	public:
+		// phase must outlive the run (a literal or __func__)
+		Scope( const char *_phase );
+		~Scope();
+	private:
+		const char *phase;
+		chrono::steady_clock::time_point start;
+		uint64_t counts[N_EVENTS];
+	};
+
+	// table of all phases in order of their first measurement
+	void report( ostream& out );
+}
+
+// PerfCounters
+
+#endif // __PERF_COUNTERS__H__
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,108 @@
+#include "Profile.h"
+
+#include <fstream>
+#include <sstream>
+
+const vector<Profile::Parameter>& Profile::parameters()
+{
+	static const vector<Parameter> space = {
+		// balanced, feasibility, optimality, best bound, hidden feasibility
+		{ "mip_emphasis", 0, { 0, 1, 2, 3, 4 } },
+		// none, automatic, moderate, aggressive
+		{ "cuts", 0, { -1, 0, 1, 2 } },
+		// none, automatic, moderate, aggressive, very aggressive
+		{ "probe", 0, { -1, 0, 1, 2, 3 } },
+		// RINS and other heuristics: none, automatic, every n nodes
+		{ "heur_freq", 0, { -1, 0, 5, 10, 20 } },
+		// depth first, best bound, best estimate, alternative best estimate
+		{ "node_sel", 1, { 0, 1, 2, 3 } },
+		// automatic, primal, dual, network, barrier
+		{ "root_alg", 0, { 0, 1, 2, 3, 4 } }
+	};
+	return space;
+}
+
+int Profile::get( const Parameter& p ) const
+{
+	auto v = values.find( p.name );
+	return (v == values.end()) ? p.default_value : v->second;
+}
+
+void Profile::set( const Parameter& p, int value )
+{
+	if( value == p.default_value ) values.erase( p.name );
+	else values[p.name] = value;
+}
+
+bool Profile::read( string file )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open profile " << file << "\n";
+		return false;
+	}
+
+	name = file;
+	values.clear();
+	string line;
+	for( unsigned int number = 1; getline( ifs, line ); number++ ) {
+		istringstream iss( line );
+		string key;
+		int value;
+		if( !(iss >> key) || key[0] == '#' ) continue;
+
+		bool known = false;
+		for( auto& p : parameters() ) known = known || p.name == key;
+		if( !known || !(iss >> value) ) {
+			cerr << file << ":" << number << ": invalid parameter \"" << line << "\"\n";
+			return false;
+		}
+		values[key] = value;
+	}
+	return true;
+}
+
+bool Profile::write( string file ) const
+{
+	ofstream ofs( file.c_str() );
+	if( ofs.fail() ) {
+		cerr << "could not write profile " << file << "\n";
+		return false;
+	}
+	ofs << "# CPLEX parameters found by kmst-tune\n";
+	for( auto& v : values ) ofs << v.first << " " << v.second << "\n";
+	return true;
+}
+
+void Profile::apply( IloCplex& cplex ) const
+{
+	static const IloCplex::IntParam cut_params[] = {
+		IloCplex::Cliques, IloCplex::Covers, IloCplex::FlowCovers, IloCplex::GUBCovers,
+		IloCplex::ImplBd, IloCplex::MIRCuts, IloCplex::FracCuts, IloCplex::ZeroHalfCuts,
+		IloCplex::DisjCuts, IloCplex::MCFCuts, IloCplex::FlowPaths
+	};
+
+	for( auto& v : values ) {
+		if( v.first == "mip_emphasis" ) cplex.setParam( IloCplex::MIPEmphasis, v.second );
+		else if( v.first == "probe" ) cplex.setParam( IloCplex::Probe, v.second );
+		else if( v.first == "heur_freq" ) cplex.setParam( IloCplex::HeurFreq, v.second );
+		else if( v.first == "node_sel" ) cplex.setParam( IloCplex::NodeSel, v.second );
+		else if( v.first == "root_alg" ) cplex.setParam( IloCplex::RootAlg, v.second );
+		else if( v.first == "cuts" ) {
+			for( auto& p : cut_params ) cplex.setParam( p, v.second );
+		}
+	}
+}
+
+string Profile::toString() const
+{
+	if( values.empty() ) return "default";
+	ostringstream oss;
+	for( auto& v : values ) {
+		if( oss.tellp() > 0 ) oss << ", ";
+		oss << v.first << "=" << v.second;
+	}
+	return oss.str();
+}
+
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,57 @@
+#ifndef __PROFILE__H__
+#define __PROFILE__H__
+
+#include <ilcplex/ilocplex.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A named set of CPLEX search parameters for a family of instances, as
+ * found by kmst-tune. Profiles are text files with one "<name> <value>" per
+ * line; parameters that are not set keep the CPLEX default.
+ */
+class Profile
+{
+
+public:
+
+	/* A tunable parameter and the values the tuner tries. "cuts" sets the
+	 * aggressiveness of all cut families at once. */
+	struct Parameter
+	{
+		string name;
+		// the CPLEX default and the values to try
+		int default_value;
+		vector<int> values;
+	};
+
+	// the search space of kmst-tune
+	static const vector<Parameter>& parameters();
+
+	// name of the profile, the file it was read from
+	string name;
+	// value of each set parameter by name
+	map<string, int> values;
+
+	bool empty() const { return values.empty(); }
+	// value of parameter p, its default if not set
+	int get( const Parameter& p ) const;
+	// set parameter p, its default value is removed from the profile
+	void set( const Parameter& p, int value );
+
+	// read a profile written by write(), returns false on unknown names
+	bool read( string file );
+	bool write( string file ) const;
+	// set the parameters of this profile on cplex
+	void apply( IloCplex& cplex ) const;
+	// "name=value, ..." for logs, "default" if empty
+	string toString() const;
+
+};
+// Profile
+
+#endif //__PROFILE__H__
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,275 @@
+#include "Solution.h"
+
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <unistd.h>
+
+Solution::Solution() :
+	k( 0 ), weight( 0 )
+{
+}
+
+/* Returns the index of edge {v1, v2} in instance, or -1 if there is none. */
+template <class Instance>
+static int findEdge( const Instance& instance, unsigned int v1, unsigned int v2 )
+{
+	if( v1 >= instance.n_nodes || v2 >= instance.n_nodes ) return -1;
+	for( auto& e : instance.incidentEdges[v1] ) {
+		const typename Instance::Edge& f = instance.edges[e];
+		if( (f.v1 == v1 && f.v2 == v2) || (f.v1 == v2 && f.v2 == v1) ) return e;
+	}
+	return -1;
+}
+
+template <class Instance>
+bool Solution::read( string file, const Instance& instance )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open solution file " << file << "\n";
+		return false;
+	}
+
+	k = 0;
+	weight = 0;
+	nodes.clear();
+	edges.clear();
+
+	unsigned int dropped = 0;
+	string line;
+	while( getline( ifs, line ) ) {
+		istringstream ss( line );
+		string tag;
+		if( !(ss >> tag) || tag[0] == '#' ) continue;
+
+		if( tag == "k" ) {
+			ss >> k;
+		} else if( tag == "weight" ) {
+			ss >> weight;
+		} else if( tag == "nodes" ) {
+			unsigned int v;
+			while( ss >> v ) {
+				if( v > 0 && v < instance.n_nodes ) nodes.push_back( v );
+			}
+		} else if( tag == "e" ) {
+			/* Edge ids are only trusted if the endpoints still match, which
+			 * allows solutions of nearby instances to be mapped by endpoints. */
+			unsigned int id, v1, v2;
+			if( !(ss >> id >> v1 >> v2) ) continue;
+			int e = -1;
+			if( id < instance.n_edges && !instance.removed[id] ) {
+				const typename Instance::Edge& f = instance.edges[id];
+				if( (f.v1 == v1 && f.v2 == v2) || (f.v1 == v2 && f.v2 == v1) ) e = id;
+			}
+			if( e < 0 ) e = findEdge( instance, v1, v2 );
+			if( e < 0 ) dropped++;
+			else edges.push_back( e );
+		}
+	}
+	ifs.close();
+
+	if( dropped > 0 ) {
+		cout << "Dropped " << dropped << " edges of " << file << " not present in instance\n";
+	}
+	return true;
+}
+
+template <class Instance>
+bool Solution::write( string file, const Instance& instance ) const
+{
+	/* Write to a temporary file first so that a killed process never
+	 * leaves a truncated solution behind. It is private to this process,
+	 * so that concurrent runs writing the same file do not share it. */
+	const string tmp = file + "." + to_string( getpid() ) + ".tmp";
+	ofstream ofs( tmp.c_str() );
+	if( ofs.fail() ) {
+		cerr << "could not open solution file " << tmp << "\n";
+		return false;
+	}
+
+	ofs << "k " << k << "\n";
+	ofs << "weight " << weight << "\n";
+	ofs << "nodes";
+	for( auto& v : nodes ) ofs << " " << v;
+	ofs << "\n";
+	for( auto& e : edges ) {
+		ofs << "e " << e << " " << instance.edges[e].v1 << " " << instance.edges[e].v2 << "\n";
+	}
+	ofs.close();
+
+	if( ofs.fail() || rename( tmp.c_str(), file.c_str() ) != 0 ) {
+		cerr << "could not write solution file " << file << "\n";
+		remove( tmp.c_str() );
+		return false;
+	}
+	return true;
+}
+
+template <class Instance>
+bool Solution::repair( const Instance& instance, int _k )
+{
+	typedef pair<double, unsigned int> WeightedEdge;
+	typedef priority_queue<WeightedEdge, vector<WeightedEdge>, greater<WeightedEdge> > MinQueue;
+
+	const unsigned int n = instance.n_nodes;
+	if( _k <= 0 || (unsigned int) _k >= n ) return false;
+
+	/* Every node mentioned by the solution is a candidate. */
+	vector<bool> wanted( n, false );
+	for( auto& v : nodes ) wanted[v] = true;
+	for( auto& e : edges ) {
+		if( instance.edges[e].v1 > 0 ) wanted[instance.edges[e].v1] = true;
+		if( instance.edges[e].v2 > 0 ) wanted[instance.edges[e].v2] = true;
+	}
+
+	/* Keep the largest connected component of the induced subgraph. */
+	vector<int> component( n, -1 );
+	int best = -1;
+	unsigned int best_size = 0;
+	for( unsigned int s = 1; s < n; s++ ) {
+		if( !wanted[s] || component[s] >= 0 ) continue;
+		unsigned int size = 0;
+		vector<unsigned int> stack( 1, s );
+		component[s] = s;
+		while( !stack.empty() ) {
+			const unsigned int v = stack.back();
+			stack.pop_back();
+			size++;
+			for( auto& e : instance.incidentEdges[v] ) {
+				const unsigned int u = instance.edges[e].v1 == v ? instance.edges[e].v2 : instance.edges[e].v1;
+				if( u == 0 || !wanted[u] || component[u] >= 0 ) continue;
+				component[u] = s;
+				stack.push_back( u );
+			}
+		}
+		if( size > best_size ) {
+			best = s;
+			best_size = size;
+		}
+	}
+	if( best < 0 ) return false;
+
+	/* Span the component by a minimum spanning tree (Prim). */
+	vector<bool> in_tree( n, false );
+	vector<vector<unsigned int> > adjacent( n );
+	unsigned int size = 0;
+	MinQueue queue;
+	queue.push( WeightedEdge( 0, instance.n_edges ) );
+	while( !queue.empty() ) {
+		const unsigned int e = queue.top().second;
+		queue.pop();
+
+		unsigned int v = best;
+		if( e < instance.n_edges ) {
+			v = in_tree[instance.edges[e].v1] ? instance.edges[e].v2 : instance.edges[e].v1;
+			if( in_tree[v] ) continue;
+			adjacent[instance.edges[e].v1].push_back( e );
+			adjacent[instance.edges[e].v2].push_back( e );
+		} else if( in_tree[v] ) {
+			continue;
+		}
+		in_tree[v] = true;
+		size++;
+
+		for( auto& f : instance.incidentEdges[v] ) {
+			const unsigned int u = instance.edges[f].v1 == v ? instance.edges[f].v2 : instance.edges[f].v1;
+			if( u != 0 && !in_tree[u] && component[u] == best ) {
+				queue.push( WeightedEdge( instance.edges[f].weight, f ) );
+			}
+		}
+	}
+
+	/* Too many nodes: repeatedly prune the leaf with the most expensive edge. */
+	if( size > (unsigned int) _k ) {
+		priority_queue<WeightedEdge> leaves;
+		for( unsigned int v = 1; v < n; v++ ) {
+			if( in_tree[v] && adjacent[v].size() == 1 ) {
+				leaves.push( WeightedEdge( instance.edges[adjacent[v][0]].weight, v ) );
+			}
+		}
+		vector<unsigned int> degree( n );
+		for( unsigned int v = 0; v < n; v++ ) degree[v] = adjacent[v].size();
+
+		while( size > (unsigned int) _k && !leaves.empty() ) {
+			const unsigned int v = leaves.top().second;
+			leaves.pop();
+			if( !in_tree[v] || degree[v] != 1 ) continue;
+
+			in_tree[v] = false;
+			degree[v] = 0;
+			size--;
+			for( auto& e : adjacent[v] ) {
+				const unsigned int u = instance.edges[e].v1 == v ? instance.edges[e].v2 : instance.edges[e].v1;
+				if( !in_tree[u] ) continue;
+				if( --degree[u] != 1 ) continue;
+				for( auto& f : adjacent[u] ) {
+					const unsigned int w = instance.edges[f].v1 == u ? instance.edges[f].v2 : instance.edges[f].v1;
+					if( in_tree[w] ) leaves.push( WeightedEdge( instance.edges[f].weight, u ) );
+				}
+			}
+		}
+	}
+
+	/* Too few nodes: grow the tree by the cheapest incident edges. */
+	if( size < (unsigned int) _k ) {
+		MinQueue candidates;
+		for( unsigned int v = 1; v < n; v++ ) {
+			if( !in_tree[v] ) continue;
+			for( auto& e : instance.incidentEdges[v] ) {
+				candidates.push( WeightedEdge( instance.edges[e].weight, e ) );
+			}
+		}
+		while( size < (unsigned int) _k && !candidates.empty() ) {
+			const unsigned int e = candidates.top().second;
+			candidates.pop();
+
+			const unsigned int v1 = instance.edges[e].v1, v2 = instance.edges[e].v2;
+			if( v1 == 0 || v2 == 0 || in_tree[v1] == in_tree[v2] ) continue;
+			const unsigned int v = in_tree[v1] ? v2 : v1;
+			in_tree[v] = true;
+			size++;
+			adjacent[v1].push_back( e );
+			adjacent[v2].push_back( e );
+			for( auto& f : instance.incidentEdges[v] ) {
+				candidates.push( WeightedEdge( instance.edges[f].weight, f ) );
+			}
+		}
+		if( size < (unsigned int) _k ) return false;
+	}
+
+	/* Collect the tree and connect it to the artificial root. */
+	k = _k;
+	weight = 0;
+	nodes.clear();
+	edges.clear();
+	for( unsigned int v = 1; v < n; v++ ) {
+		if( !in_tree[v] ) continue;
+		nodes.push_back( v );
+		for( auto& e : adjacent[v] ) {
+			const unsigned int u = instance.edges[e].v1 == v ? instance.edges[e].v2 : instance.edges[e].v1;
+			if( u > v && in_tree[u] ) {
+				edges.push_back( e );
+				weight += instance.edges[e].weight;
+			}
+		}
+	}
+	for( auto& e : instance.incidentEdges[0] ) {
+		const unsigned int u = instance.edges[e].v1 == 0 ? instance.edges[e].v2 : instance.edges[e].v1;
+		if( in_tree[u] ) {
+			edges.push_back( e );
+			weight += instance.edges[e].weight;
+			return true;
+		}
+	}
+	return false;
+}
+
+#define INSTANTIATE( Index, Weight ) \
+	template bool Solution::read( string, const BasicInstance<Index, Weight>& ); \
+	template bool Solution::write( string, const BasicInstance<Index, Weight>& ) const; \
+	template bool Solution::repair( const BasicInstance<Index, Weight>&, int );
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,50 @@
+#ifndef __SOLUTION__H__
+#define __SOLUTION__H__
+
+#include "Instance.h"
+#include "Tools.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+
+using namespace std;
+
+/**
+ * A k-tree in terms of an instance: the active nodes and the active edges
+ * (indices into Instance::edges, including the edge from the artificial
+ * root 0). Solutions are stored in a compact text file and can be read back
+ * and repaired to serve as a start for the same or a nearby instance / k.
+ */
+class Solution
+{
+
+public:
+
+	// number of active nodes (not counting the artificial root)
+	int k;
+	// total weight of the active edges
+	double weight;
+	// active nodes, not including the artificial root 0
+	vector<unsigned int> nodes;
+	// active edges by index into Instance::edges, including the root edge
+	vector<unsigned int> edges;
+
+	Solution();
+
+	// read a solution written by write() and map its edges onto instance
+	template <class Instance>
+	bool read( string file, const Instance& instance );
+	// write solution to file, replacing it atomically
+	template <class Instance>
+	bool write( string file, const Instance& instance ) const;
+	// turn this into a valid k-tree of instance (drop missing edges,
+	// prune or grow to k nodes); returns false if that is impossible
+	template <class Instance>
+	bool repair( const Instance& instance, int k );
+
+};
+// Solution
+
+#endif //__SOLUTION__H__
+/* vim: set noet ts=4 sw=4: */
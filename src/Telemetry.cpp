@@ -0,0 +1,81 @@
+#include "Telemetry.h"
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+// pause of the writer thread when the buffer is empty
+static const chrono::milliseconds WRITER_PAUSE( 100 );
+
+Telemetry::Telemetry( string file, double _interval, bool append ) :
+	out( file.c_str(), append ? ios::app : ios::out ), interval( _interval ), last( -numeric_limits<double>::infinity() ),
+	ring( CAPACITY ), head( 0 ), tail( 0 ), running( true ), n_written( 0 ), n_dropped( 0 )
+{
+	producing.clear();
+	if( out.fail() ) {
+		cerr << "Telemetry: could not open " << file << "\n";
+		return;
+	}
+	out << "# time bound incumbent gap nodes open_nodes cuts\n";
+	writer = thread( &Telemetry::drain, this );
+}
+
+Telemetry::~Telemetry()
+{
+	close();
+}
+
+void Telemetry::close()
+{
+	running = false;
+	if( writer.joinable() ) writer.join();
+}
+
+bool Telemetry::claim( double time )
+{
+	// cheap check first, then again as the owner of the producer side, so
+	// that a caller right after the previous owner does not sample twice
+	if( time - last.load( memory_order_relaxed ) < interval ) return false;
+	if( producing.test_and_set( memory_order_acquire ) ) return false;
+	if( time - last.load( memory_order_relaxed ) < interval ) {
+		producing.clear( memory_order_release );
+		return false;
+	}
+	last.store( time, memory_order_relaxed );
+	return true;
+}
+
+void Telemetry::push( const Sample& sample )
+{
+	const unsigned long h = head.load( memory_order_relaxed );
+	if( h - tail.load( memory_order_acquire ) < CAPACITY ) {
+		ring[h % CAPACITY] = sample;
+		head.store( h + 1, memory_order_release );
+	} else {
+		n_dropped++;
+	}
+	producing.clear( memory_order_release );
+}
+
+/* Writer thread: empties the buffer, then sleeps until the next batch. The
+ * final pass after running is cleared picks up the last samples. */
+void Telemetry::drain()
+{
+	bool last_pass = false;
+	while( !last_pass ) {
+		last_pass = !running;
+		unsigned long t = tail.load( memory_order_relaxed );
+		const unsigned long h = head.load( memory_order_acquire );
+		for( ; t < h; t++ ) {
+			const Sample& s = ring[t % CAPACITY];
+			out << s.time << " " << s.bound << " " << s.incumbent << " " << s.gap << " "
+				<< s.nodes << " " << s.open_nodes << " " << s.cuts << "\n";
+			n_written++;
+		}
+		tail.store( t, memory_order_release );
+		out.flush();
+		if( !last_pass ) this_thread::sleep_for( WRITER_PAUSE );
+	}
+}
+
+/* vim: set noet ts=4 sw=4: */
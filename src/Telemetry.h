@@ -0,0 +1,76 @@
+#ifndef __TELEMETRY__H__
+#define __TELEMETRY__H__
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Progress samples of a branch-and-bound run, taken at a fixed interval and
+ * passed through a lock-free single-producer ring buffer to a writer thread,
+ * which appends them as whitespace-separated columns to a file.
+ */
+class Telemetry
+{
+
+public:
+
+	struct Sample
+	{
+		// seconds since the start of the solve
+		double time;
+		double bound, incumbent, gap;
+		long nodes, open_nodes, cuts;
+	};
+
+	// number of samples buffered before new ones are dropped
+	static const unsigned int CAPACITY = 4096;
+
+	// starts the writer thread if file can be opened (for appending if
+	// append is set)
+	Telemetry( string file, double interval, bool append = false );
+	~Telemetry();
+
+	// writes all pending samples and stops the writer thread
+	void close();
+
+	// true until close() if the file could be opened
+	bool isOpen() const { return writer.joinable(); }
+
+	// returns true if a sample is due at time; the caller then owns the
+	// producer side and must hand the sample to push(), concurrent callers
+	// get false
+	bool claim( double time );
+	// stores a sample claimed before, dropping it if the buffer is full
+	void push( const Sample& sample );
+
+	unsigned long written() const { return n_written; }
+	unsigned long dropped() const { return n_dropped; }
+
+private:
+
+	ofstream out;
+	double interval;
+	// time of the last claimed sample, read by all callers of claim()
+	atomic<double> last;
+
+	vector<Sample> ring;
+	// next slot to write (producer) and to read (writer thread)
+	atomic<unsigned long> head, tail;
+	atomic_flag producing;
+	atomic<bool> running;
+	thread writer;
+
+	unsigned long n_written, n_dropped;
+
+	void drain();
+
+};
+// Telemetry
+
+#endif //__TELEMETRY__H__
+/* vim: set noet ts=4 sw=4: */
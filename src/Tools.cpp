@@ -3,7 +3,7 @@
 
 #include "Tools.h"
 
-#include <unistd.h>
+#include <sys/resource.h>
 
 string Tools::indicesToString( string prefix, int i, int j, int v )
 {
@@ -17,10 +17,18 @@ string Tools::indicesToString( string prefix, int i, int j, int v )
 
 double Tools::CPUtime()
 {
-	tms t;
-	times( &t );
-	double ct = sysconf( _SC_CLK_TCK );
-	return t.tms_utime / ct;
+	// microseconds instead of the clock ticks of times()
+	rusage r;
+	getrusage( RUSAGE_SELF, &r );
+	return r.ru_utime.tv_sec + r.ru_utime.tv_usec / 1e6;
+}
+
+double Tools::peakMemory()
+{
+	rusage r;
+	getrusage( RUSAGE_SELF, &r );
+	// ru_maxrss is given in kB
+	return r.ru_maxrss / 1024.0;
 }
 
 #endif // __TOOLS__CPP__
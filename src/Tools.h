@@ -22,6 +22,8 @@ namespace Tools
 	string indicesToString( string prefix, int i, int j = -1, int v = -1 );
 	// measure running time
 	double CPUtime();
+	// peak resident memory of the process in MB
+	double peakMemory();
 }
 
 // Tools
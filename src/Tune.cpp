@@ -0,0 +1,220 @@
+#ifndef __TUNE__CPP__
+#define __TUNE__CPP__
+
+#include <iostream>
+#include <chrono>
+#include <limits>
+#include <getopt.h>
+
+#include "Instance.h"
+#include "Profile.h"
+#include "kMST_ILP.h"
+
+using namespace std;
+
+/**
+ * Finds a Profile for a family of instances by racing: starting from the
+ * CPLEX defaults, every value of every parameter (see Profile::parameters())
+ * is tried in turn on all training jobs and kept if it lowers the total
+ * solve time. A candidate is dropped as soon as its time exceeds that of
+ * the best profile so far. Jobs not solved to optimality within the time
+ * limit count twice the limit.
+ */
+
+static const double INF = numeric_limits<double>::infinity();
+
+// relative improvement a candidate needs to replace the best profile, so
+// that timing noise does not change it
+static const double MIN_GAIN = 0.05;
+
+void usage()
+{
+	cout << "USAGE:\t<program> -t training set -o profile [options]\n";
+	cout << "TRAINING SET:\tone job \"<instance file> <k> <model>\" per line\n";
+	cout << "OPTIONS:\n";
+	cout << "\t--time-limit <sec>\tlimit of each job (default 60)\n";
+	cout << "\t--passes <n>\t\tpasses over all parameters (default 2)\n";
+	cout << "\t--start <file>\t\tstart from this profile instead of the defaults\n";
+	cout << "EXAMPLE:\t" << "./kmst-tune -t data/train.txt -o data/g.profile\n\n";
+	exit( 1 );
+} // usage
+
+/* A training job, its instance is read once. */
+struct Job
+{
+	string file;
+	int k;
+	string model_type;
+
+	Job( string _file, int _k, string _model_type ) : file( _file ), k( _k ), model_type( _model_type ) { }
+	virtual ~Job() { }
+	// returns the status of kMST_ILP::solve()
+	virtual int solve( const kMST_ILP_Base::Options& options ) = 0;
+}; // Job
+
+template <class Instance>
+struct InstanceJob : public Job
+{
+	Instance instance;
+
+	InstanceJob( string _file, int _k, string _model_type ) :
+		Job( _file, _k, _model_type ), instance( _file, false ) { }
+
+	int solve( const kMST_ILP_Base::Options& options )
+	{
+		return kMST_ILP<Instance>( instance, model_type, k, options ).solve();
+	}
+}; // InstanceJob
+
+/* Reads a job in the narrowest representation, see InstanceFormat::dispatch(). */
+struct Load
+{
+	string file;
+	int k;
+	string model_type;
+	Job *job;
+
+	Load( string _file, int _k, string _model_type ) :
+		file( _file ), k( _k ), model_type( _model_type ), job( 0 ) { }
+
+	template <class Instance>
+	int run()
+	{
+		job = new InstanceJob<Instance>( file, k, model_type );
+		return 0;
+	}
+}; // Load
+
+bool readJobs( string file, vector<Job *>& jobs )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open training set " << file << "\n";
+		return false;
+	}
+
+	string line;
+	for( unsigned int number = 1; getline( ifs, line ); number++ ) {
+		istringstream iss( line );
+		string instance, model_type;
+		int k;
+		if( !(iss >> instance) || instance[0] == '#' ) continue;
+		if( !(iss >> k >> model_type) ) {
+			cerr << file << ":" << number << ": invalid job \"" << line << "\"\n";
+			return false;
+		}
+		Load load( instance, k, model_type );
+		InstanceFormat( instance ).dispatch( load );
+		jobs.push_back( load.job );
+	}
+	return !jobs.empty();
+}
+
+/* Stream buffer discarding everything written to it. */
+class NullBuffer : public streambuf
+{
+protected:
+	int overflow( int c ) { return traits_type::not_eof( c ); }
+	streamsize xsputn( const char *, streamsize n ) { return n; }
+}; // NullBuffer
+
+/* Total seconds of profile on all jobs, INF once they exceed budget. */
+double evaluate( const vector<Job *>& jobs, const Profile& profile, double time_limit, double budget )
+{
+	// discards the output of the solver and CPLEX
+	NullBuffer null_buffer;
+	ostream null( &null_buffer );
+
+	double total = 0;
+	for( auto& job : jobs ) {
+		if( total >= budget ) return INF;
+
+		kMST_ILP_Base::Options options;
+		options.log = &null;
+		options.mip_display = 0;
+		options.profile = profile;
+		options.time_limit = min( time_limit, budget - total );
+
+		const auto start = chrono::steady_clock::now();
+		const int status = job->solve( options );
+		total += chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+		if( status != kMST_ILP_Base::OPTIMAL ) total += time_limit;
+	}
+	return (total > budget) ? INF : total;
+}
+
+int main( int argc, char *argv[] )
+{
+	static const struct option long_options[] = {
+		{ "time-limit", required_argument, 0, 'T' },
+		{ "passes", required_argument, 0, 'n' },
+		{ "start", required_argument, 0, 's' },
+		{ 0, 0, 0, 0 }
+	};
+
+	string training, output;
+	double time_limit = 60;
+	int passes = 2;
+	Profile best;
+	int opt;
+	while( (opt = getopt_long( argc, argv, "t:o:", long_options, 0 )) != EOF ) {
+		switch( opt ) {
+			case 't': // training jobs
+				training = optarg;
+				break;
+			case 'o': // profile to write
+				output = optarg;
+				break;
+			case 'T': // limit of each job
+				time_limit = atof( optarg );
+				break;
+			case 'n': // passes over all parameters
+				passes = atoi( optarg );
+				break;
+			case 's': // initial profile
+				if( !best.read( optarg ) ) return -1;
+				break;
+			default:
+				usage();
+				break;
+		}
+	}
+	if( training.empty() || output.empty() || time_limit <= 0 ) usage();
+
+	vector<Job *> jobs;
+	if( !readJobs( training, jobs ) ) return -1;
+
+	double best_time = evaluate( jobs, best, time_limit, INF );
+	cout << "\n" << best.toString() << ": " << best_time << " s\n";
+
+	for( int pass = 1; pass <= passes; pass++ ) {
+		bool improved = false;
+		for( auto& p : Profile::parameters() ) {
+			for( auto& value : p.values ) {
+				if( value == best.get( p ) ) continue;
+
+				Profile candidate = best;
+				candidate.set( p, value );
+				const double time = evaluate( jobs, candidate, time_limit, best_time * (1 - MIN_GAIN) );
+				cout << "pass " << pass << ", " << p.name << "=" << value << ": ";
+				if( time == INF ) cout << "dropped\n";
+				else cout << time << " s\n";
+
+				if( time < best_time * (1 - MIN_GAIN) ) {
+					best = candidate;
+					best_time = time;
+					improved = true;
+				}
+			}
+		}
+		cout << "after pass " << pass << ": " << best.toString() << ", " << best_time << " s\n";
+		if( !improved ) break;
+	}
+
+	for( auto& job : jobs ) delete job;
+	return best.write( output ) ? 0 : -1;
+} // main
+
+#endif // __TUNE__CPP__
+
+/* vim: set noet ts=4 sw=4: */
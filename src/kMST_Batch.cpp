@@ -0,0 +1,119 @@
+#include "kMST_Batch.h"
+
+#include <chrono>
+#include <limits>
+#include <thread>
+
+bool parseKList( string list, vector<int>& ks )
+{
+	istringstream iss( list );
+	string item;
+	while( getline( iss, item, ',' ) ) {
+		int first, last;
+		char dash;
+		istringstream range( item );
+		if( !(range >> first) ) return false;
+		last = first;
+		if( range >> dash && (dash != '-' || !(range >> last)) ) return false;
+		if( first < 1 || last < first ) return false;
+		for( int k = first; k <= last; k++ ) ks.push_back( k );
+	}
+	sort( ks.begin(), ks.end() );
+	ks.erase( unique( ks.begin(), ks.end() ), ks.end() );
+	return !ks.empty();
+}
+
+// file name for the output of one k, empty names and "-" (stdout, where
+// incumbent lines carry their k) stay as they are
+static string suffixed( string file, int k )
+{
+	if( file.empty() || file == "-" ) return file;
+	return file + ".k" + to_string( k );
+}
+
+// true if no edge weighs less than 0, see BoundTable
+template <class Instance>
+static bool nonNegative( const Instance& instance )
+{
+	for( unsigned int e = 0; e < instance.n_edges; e++ ) {
+		if( !instance.removed[e] && instance.edges[e].weight < 0 ) return false;
+	}
+	return true;
+}
+
+template <class Instance>
+kMST_Batch<Instance>::kMST_Batch( Instance& _instance, string _model_type, const vector<int>& _ks, int _workers,
+		const kMST_ILP_Base::Options& _options ) :
+	instance( _instance ), model_type( _model_type ), ks( _ks ), workers( _workers ), options( _options ),
+	bounds( _ks.empty() ? 0 : *max_element( _ks.begin(), _ks.end() ), nonNegative( _instance ) ), results( _ks.size() ), next( 0 )
+{
+	// largest k first, their trees bound the smaller ones
+	sort( ks.rbegin(), ks.rend() );
+	if( workers <= 0 ) workers = max( 1u, thread::hardware_concurrency() );
+	workers = min( workers, (int) ks.size() );
+	// share the hardware threads among the workers unless set explicitly
+	if( options.threads == 0 ) {
+		options.threads = max( 1, (int) thread::hardware_concurrency() / max( workers, 1 ) );
+	}
+}
+
+template <class Instance>
+int kMST_Batch<Instance>::solve()
+{
+	cout << "Solving " << ks.size() << " values of k with " << workers << " workers of "
+		<< options.threads << " threads\n";
+	if( !bounds.isMonotone() ) cout << "Negative edge weights: lower bounds are not shared between values of k\n";
+	cout << "\n";
+
+	vector<thread> threads;
+	for( int t = 0; t < workers; t++ ) {
+		threads.push_back( thread( &kMST_Batch::worker, this ) );
+	}
+	for( auto& t : threads ) t.join();
+
+	static const char *names[] = { "optimal", "feasible", "none" };
+	int worst = kMST_ILP_Base::OPTIMAL;
+	cout << "k\tobjective\tbound\tstatus\twall time\n";
+	for( unsigned int i = 0; i < ks.size(); i++ ) {
+		const int k = ks[ks.size() - 1 - i];
+		const Result& r = results[ks.size() - 1 - i];
+		Solution tree;
+		cout << k << "\t";
+		if( bounds.tree( k, tree ) ) cout << tree.weight;
+		else cout << "-";
+		cout << "\t" << bounds.lowerBound( k ) << "\t" << names[r.status] << "\t" << r.time << "\n";
+		worst = max( worst, r.status );
+	}
+	return worst;
+}
+
+template <class Instance>
+void kMST_Batch<Instance>::worker()
+{
+	unsigned int i;
+	while( (i = next++) < ks.size() ) {
+		const int k = ks[i];
+		const auto start = chrono::steady_clock::now();
+
+		ostringstream log;
+		kMST_ILP_Base::Options o = options;
+		o.log = &log;
+		o.bounds = &bounds;
+		o.save_solution = suffixed( options.save_solution, k );
+		o.checkpoint = suffixed( options.checkpoint, k );
+		o.incumbents = suffixed( options.incumbents, k );
+		o.telemetry = suffixed( options.telemetry, k );
+
+		results[i].status = kMST_ILP<Instance>( instance, model_type, k, o ).solve();
+		results[i].time = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+		lock_guard<mutex> guard( output_mutex );
+		cout << "=== k = " << k << " ===\n" << log.str() << flush;
+	}
+}
+
+#define INSTANTIATE( Index, Weight ) template class kMST_Batch<BasicInstance<Index, Weight> >;
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,61 @@
+#ifndef __K_MST_BATCH__H__
+#define __K_MST_BATCH__H__
+
+#include <atomic>
+#include <mutex>
+
+#include "BoundTable.h"
+#include "Instance.h"
+#include "kMST_ILP.h"
+
+using namespace std;
+
+// parse a list of k values like "1-20,25", returns false if it is invalid
+bool parseKList( string list, vector<int>& ks );
+
+/**
+ * Solves one instance for many k at once. Workers take k values in
+ * decreasing order, each solving with its own kMST_ILP (and IloEnv), and
+ * share bounds and trees through a BoundTable: the tree for k + 1 gives an
+ * upper cutoff and start for k, and with non-negative weights bounds proven
+ * for smaller k may end a solve early. Output of each k is buffered and
+ * printed when it is done.
+ */
+template <class Instance>
+class kMST_Batch
+{
+
+public:
+
+	// workers: number of concurrent solves, 0 for one per hardware thread
+	kMST_Batch( Instance& _instance, string _model_type, const vector<int>& _ks, int _workers,
+			const kMST_ILP_Base::Options& _options = kMST_ILP_Base::Options() );
+	// returns the worst status of all solves (see kMST_ILP_Base::Status)
+	int solve();
+
+private:
+
+	struct Result
+	{
+		int status;
+		double time;
+	};
+
+	Instance& instance;
+	string model_type;
+	vector<int> ks;
+	int workers;
+	kMST_ILP_Base::Options options;
+
+	BoundTable bounds;
+	vector<Result> results;
+	atomic<unsigned int> next;
+	mutex output_mutex;
+
+	void worker();
+
+};
+// kMST_Batch
+
+#endif //__K_MST_BATCH__H__
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,251 @@
+#include "kMST_Enum.h"
+#include "DenseGraph.h"
+
+#include <limits>
+#include <set>
+#include <thread>
+
+static const double INF = numeric_limits<double>::infinity();
+
+// largest estimated work of suitable(), a few seconds on one core
+static const double AUTO_WORK = 2e7;
+
+template <class Instance>
+struct kMST_Enum<Instance>::Search
+{
+	// start node, only nodes above it may join the tree
+	unsigned int start;
+	// nodes in the tree and their weight
+	vector<unsigned int> nodes;
+	vector<bool> in_tree;
+	double weight;
+	// excluded edges
+	vector<bool> excluded;
+	// weight of the lightest excluded edge from the tree to each node
+	vector<double> ban;
+	// bounds of the start node, see computeBounds()
+	const double *node_prefix, *edge_prefix;
+	// search nodes, added to bb_nodes when done
+	unsigned long count;
+};
+
+template <class Instance>
+kMST_Enum<Instance>::kMST_Enum( Instance& _instance, int _k, string _save_solution ) :
+	instance( _instance ), k( _k ), save_solution( _save_solution ), n( _instance.n_nodes ),
+	adjacent( _instance.n_nodes ), best_weight( INF ), next_start( 1 ), bb_nodes( 0 )
+{
+	for( unsigned int e = 0; e < instance.n_edges; e++ ) {
+		const typename Instance::Edge& f = instance.edges[e];
+		if( f.v1 == 0 || f.v2 == 0 || instance.removed[e] ) continue;
+		adjacent[f.v1].push_back( WeightedEdge( f.weight, e ) );
+		adjacent[f.v2].push_back( WeightedEdge( f.weight, e ) );
+	}
+	for( auto& a : adjacent ) sort( a.begin(), a.end() );
+}
+
+/* The bounds take about m log n steps. The search visits about n b^(k - 1)
+ * trees, where the branching b grows with the average degree up to 2 on
+ * the instances of kmst-gen. */
+template <class Instance>
+bool kMST_Enum<Instance>::suitable( const Instance& instance, int k, int max_k )
+{
+	if( k < 1 || k > max_k ) return false;
+
+	unsigned long edges = 0;
+	for( unsigned int e = 0; e < instance.n_edges; e++ ) {
+		const typename Instance::Edge& f = instance.edges[e];
+		if( f.v1 != 0 && f.v2 != 0 && !instance.removed[e] ) edges++;
+	}
+	const double n = max( 1u, instance.n_nodes - 1 );
+	const double m = edges;
+	const double branching = min( 2.0, max( 1.0, m / n ) );
+	return m * log2( n + 1 ) + n * pow( branching, k - 1 ) <= AUTO_WORK;
+}
+
+template <class Instance>
+int kMST_Enum<Instance>::solve()
+{
+	cout << "Enumerating trees with " << k << " nodes ...\n";
+
+	if( k >= 1 && (unsigned int) k < n ) {
+		computeBounds();
+
+		// the best Prim k-tree is a good first upper bound
+		vector<unsigned int> nodes;
+		const double weight = bestPrimKTree( instance, k, nodes );
+		if( weight < INF ) improve( nodes, weight );
+
+		vector<thread> threads;
+		const unsigned int n_threads = max( 1u, thread::hardware_concurrency() );
+		for( unsigned int t = 0; t < n_threads; t++ ) {
+			threads.push_back( thread( &kMST_Enum::worker, this ) );
+		}
+		for( auto& t : threads ) t.join();
+	}
+
+	cout << "Branch-and-Bound nodes: " << bb_nodes.load() << "\n";
+	if( best_weight == INF ) {
+		cout << "No tree with " << k << " nodes\n";
+		cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+		return 2;
+	}
+	cout << "Objective value: " << best_weight.load() << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n";
+	cout << "Peak memory: " << Tools::peakMemory() << " MB\n\n";
+
+	if( !save_solution.empty() ) {
+		// the minimum spanning tree of the best nodes is the best tree
+		Solution solution;
+		solution.nodes = best_nodes;
+		if( solution.repair( instance, k ) ) solution.write( save_solution, instance );
+	}
+	return 0;
+}
+
+/* Takes start nodes until none are left. */
+template <class Instance>
+void kMST_Enum<Instance>::worker()
+{
+	Search s;
+	s.in_tree.assign( n, false );
+	s.excluded.assign( instance.n_edges, false );
+	s.ban.assign( n, INF );
+	s.count = 0;
+
+	for( unsigned int start = next_start++; start < n; start = next_start++ ) {
+		s.start = start;
+		s.node_prefix = &node_prefixes[(size_t) start * k];
+		s.edge_prefix = &edge_prefixes[(size_t) start * k];
+		// less than k - 1 other nodes can join the tree
+		if( s.node_prefix[k - 1] == INF ) continue;
+
+		s.nodes.assign( 1, start );
+		s.in_tree[start] = true;
+		s.weight = 0;
+		search( s );
+		s.in_tree[start] = false;
+	}
+	bb_nodes += s.count;
+}
+
+/* Lower bounds on r missing nodes of a tree whose smallest node is start:
+ * each of them is attached by its own edge, which is at least the cheapest
+ * edge from that node to another node >= start, and the r edges are distinct
+ * edges among the nodes >= start. Start nodes are swept downwards, so that
+ * the cheapest edges and the lightest edges are updated rather than
+ * recomputed, in O(m log n + n k) for all start nodes. */
+template <class Instance>
+void kMST_Enum<Instance>::computeBounds()
+{
+	node_prefixes.assign( (size_t) n * k, INF );
+	edge_prefixes.assign( (size_t) n * k, INF );
+
+	// cheapest edge of each node >= start to another one, and the k - 1
+	// lightest edges among the nodes >= start
+	vector<double> cheapest( n, INF );
+	multiset<double> node_weights, edge_weights;
+	vector<multiset<double>::iterator> position( n, node_weights.end() );
+
+	for( unsigned int start = n - 1; start >= 1; start-- ) {
+		for( auto& a : adjacent[start] ) {
+			const typename Instance::Edge& f = instance.edges[a.second];
+			const unsigned int u = (f.v1 == start) ? f.v2 : f.v1;
+			if( u < start ) continue;
+
+			// adjacent is sorted, the first edge upwards is the cheapest
+			if( cheapest[start] == INF ) cheapest[start] = a.first;
+			if( a.first < cheapest[u] ) {
+				if( cheapest[u] < INF ) node_weights.erase( position[u] );
+				cheapest[u] = a.first;
+				position[u] = node_weights.insert( a.first );
+			}
+			edge_weights.insert( a.first );
+			if( edge_weights.size() > (size_t) k - 1 ) edge_weights.erase( prev( edge_weights.end() ) );
+		}
+		if( cheapest[start] < INF ) position[start] = node_weights.insert( cheapest[start] );
+
+		double *node_prefix = &node_prefixes[(size_t) start * k];
+		double *edge_prefix = &edge_prefixes[(size_t) start * k];
+		node_prefix[0] = edge_prefix[0] = 0;
+		auto node = node_weights.begin();
+		auto edge = edge_weights.begin();
+		for( int r = 1; r < k; r++ ) {
+			if( node != node_weights.end() ) node_prefix[r] = node_prefix[r - 1] + *node++;
+			if( edge != edge_weights.end() ) edge_prefix[r] = edge_prefix[r - 1] + *edge++;
+		}
+	}
+}
+
+/* Tries the edges leaving the tree by increasing weight: the current one is
+ * added to the tree after all lighter ones were excluded. */
+template <class Instance>
+void kMST_Enum<Instance>::search( Search& s )
+{
+	s.count++;
+	if( s.nodes.size() == (unsigned int) k ) {
+		if( s.weight < best_weight ) improve( s.nodes, s.weight );
+		return;
+	}
+	const unsigned int r = k - s.nodes.size();
+
+	vector<unsigned int> excluded;
+	vector<pair<unsigned int, double> > banned;
+	for( ;; ) {
+		// lightest edge leaving the tree
+		double c = INF;
+		unsigned int edge = 0, node = 0;
+		for( auto& v : s.nodes ) {
+			for( auto& a : adjacent[v] ) {
+				if( a.first >= c ) break;
+				const typename Instance::Edge& f = instance.edges[a.second];
+				const unsigned int u = (f.v1 == v) ? f.v2 : f.v1;
+				if( u < s.start || s.in_tree[u] || s.excluded[a.second] ) continue;
+				c = a.first;
+				edge = a.second;
+				node = u;
+				break;
+			}
+		}
+		if( c == INF ) break;
+
+		const double bound = s.weight + max( max( c + s.node_prefix[r - 1], s.node_prefix[r] ), s.edge_prefix[r] );
+		if( bound >= best_weight ) break;
+
+		s.excluded[edge] = true;
+		excluded.push_back( edge );
+
+		// a lighter excluded edge would attach node more cheaply
+		if( c > s.ban[node] ) continue;
+
+		s.nodes.push_back( node );
+		s.in_tree[node] = true;
+		s.weight += c;
+		search( s );
+		s.weight -= c;
+		s.in_tree[node] = false;
+		s.nodes.pop_back();
+
+		if( c < s.ban[node] ) {
+			banned.push_back( make_pair( node, s.ban[node] ) );
+			s.ban[node] = c;
+		}
+	}
+
+	for( auto& e : excluded ) s.excluded[e] = false;
+	for( auto it = banned.rbegin(); it != banned.rend(); ++it ) s.ban[it->first] = it->second;
+}
+
+template <class Instance>
+void kMST_Enum<Instance>::improve( const vector<unsigned int>& nodes, double weight )
+{
+	lock_guard<mutex> lock( best_mutex );
+	if( weight >= best_weight ) return;
+	best_weight = weight;
+	best_nodes = nodes;
+}
+
+#define INSTANTIATE( Index, Weight ) template class kMST_Enum<BasicInstance<Index, Weight> >;
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
+/* vim: set noet ts=4 sw=4: */
@@ -0,0 +1,74 @@
+#ifndef __K_MST_ENUM__H__
+#define __K_MST_ENUM__H__
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "Instance.h"
+#include "Solution.h"
+#include "Tools.h"
+
+using namespace std;
+
+/**
+ * Exact solver for small k without CPLEX. For every start node s, trees
+ * whose smallest node is s are enumerated depth-first by adding the cheapest
+ * remaining edge leaving the tree or excluding it for good. Subtrees are
+ * pruned by lower bounds on the weight of the missing edges and by
+ * dominance: a node is never attached by an edge heavier than an excluded
+ * edge to the same node. Start nodes are processed in parallel and share the
+ * best tree found, which is seeded with the best Prim k-tree.
+ */
+template <class Instance>
+class kMST_Enum
+{
+
+public:
+
+	kMST_Enum( Instance& _instance, int _k, string _save_solution = "" );
+	// true if k <= max_k and the estimated work for the bounds and the
+	// search is small enough, see AUTO_WORK
+	static bool suitable( const Instance& instance, int k, int max_k );
+	// returns 0 if an optimal tree was found, 2 if there is no k-tree
+	// (the exit codes of kMST_ILP)
+	int solve();
+
+private:
+
+	typedef pair<double, unsigned int> WeightedEdge;
+
+	// state of the search of one thread
+	struct Search;
+
+	Instance& instance;
+	int k;
+	string save_solution;
+	unsigned int n;
+
+	// incident edges of each node by increasing weight, without root edges
+	vector<vector<WeightedEdge> > adjacent;
+
+	// for each start node (k entries each): sums of the r smallest
+	// cheapest-edge weights and of the r lightest edges, +inf if there are
+	// not r of them, for r < k
+	vector<double> node_prefixes, edge_prefixes;
+
+	// best tree so far, shared by all threads
+	mutex best_mutex;
+	atomic<double> best_weight;
+	vector<unsigned int> best_nodes;
+
+	atomic<unsigned int> next_start;
+	atomic<unsigned long> bb_nodes;
+
+	void computeBounds();
+	void worker();
+	void search( Search& s );
+	void improve( const vector<unsigned int>& nodes, double weight );
+
+};
+// kMST_Enum
+
+#endif //__K_MST_ENUM__H__
+/* vim: set noet ts=4 sw=4: */
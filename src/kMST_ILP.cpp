@@ -1,12 +1,78 @@
 #include "kMST_ILP.h"
+#include "DenseGraph.h"
+#include "PerfCounters.h"
 
 #include <assert.h>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <unistd.h>
+
+/* A tree in terms of the arcs of ArcView, oriented away from the
+ * artificial root 0. */
+struct RootedTree
+{
+	// active arcs
+	vector<u_int> arcs;
+	// arc entering each node, -1 for inactive nodes and the root
+	vector<int> parent;
+	// node preceding each node, -1 for inactive nodes and the root
+	vector<int> pred;
+	// distance from the root, 0 for inactive nodes
+	vector<int> depth;
+	// number of nodes in the subtree below (and including) each node
+	vector<int> size;
+};
 
 class Variables
 {
 public:
 	virtual ~Variables() { }
 	virtual void print(IloCplex &cplex) = 0;
+	/* Append start values of the model-specific variables for tree. */
+	virtual void addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals) = 0;
+	/* Relax integrality of all variables. */
+	virtual void relax(IloModel model)
+	{
+		model.add(IloConversion(model.getEnv(), xs, ILOFLOAT));
+		model.add(IloConversion(model.getEnv(), vs, ILOFLOAT));
+	}
+	/* Renumber the model-specific variables after edges were added (see
+	 * kMST_ILP::addEdges()): arc a was arc from[a], or is the new arc
+	 * (tail[a], head[a]) if from[a] < 0, which gets its columns and rows.
+	 * xs is renumbered already. */
+	virtual void addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+			const vector<u_int> &head, int k) = 0;
+
+	IloBoolVarArray xs;
+	IloBoolVarArray vs;
+	IloObjective objective;
+
+	/* Rows with coefficients of x, kept so that added arcs can be entered:
+	 * $\sum_{i, j > 0} x_{ij}$, $(k - 1)v_i - \sum_j x_{ij}$ and
+	 * $\sum_j (x_{ij} + x_{ji}) - v_i$ for all i, $\sum_i x_{ij} - v_j$ for
+	 * j > 0 at j - 1. Empty for a cached model. */
+	IloRange edge_count;
+	IloRangeArray out_degree;
+	IloRangeArray degree;
+	IloRangeArray in_degree;
+};
+
+/* Variables of a model read from the model cache: x and v are found by
+ * name, all model-specific variables are kept in one array. */
+class CachedVariables : public Variables
+{
+public:
+	~CachedVariables();
+	void print(IloCplex &cplex);
+	/* Model-specific variables are left to CPLEX to complete. */
+	void addStart(const RootedTree &, IloNumVarArray &, IloNumArray &) { }
+	void relax(IloModel model);
+	/* Not used, a cached model is rebuilt for added edges. */
+	void addArcs(IloModel, const vector<int> &, const vector<u_int> &, const vector<u_int> &, int) { }
+
+	IloNumVarArray others;
 };
 
 class MTZVariables : public Variables
@@ -14,9 +80,11 @@ class MTZVariables : public Variables
 public:
 	~MTZVariables();
 	void print(IloCplex &cplex);
+	void addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals);
+	void relax(IloModel model);
+	void addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+			const vector<u_int> &head, int k);
 
-	IloBoolVarArray xs;
-	IloBoolVarArray vs;
 	IloIntVarArray us;
 };
 
@@ -25,10 +93,14 @@ class SCFVariables : public Variables
 public:
 	~SCFVariables();
 	void print(IloCplex &cplex);
+	void addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals);
+	void relax(IloModel model);
+	void addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+			const vector<u_int> &head, int k);
 
-	IloBoolVarArray xs;
-	IloBoolVarArray vs;
 	IloIntVarArray fs;
+	// flow conservation row of node i > 0 at i - 1
+	IloRangeArray flow;
 };
 
 class MCFVariables : public Variables
@@ -36,95 +108,968 @@ class MCFVariables : public Variables
 public:
 	~MCFVariables();
 	void print(IloCplex &cplex);
+	void addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals);
+	void relax(IloModel model);
+	void addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+			const vector<u_int> &head, int k);
 
-	IloBoolVarArray xs;
-	IloBoolVarArray vs;
+	// flow variables of commodity l on arcs[l], empty for l = 0
 	vector<IloIntVarArray> fss;
+	vector<vector<u_int> > arcs;
+	// rows of commodity l: the flow into and out of node i > 0 at i - 1,
+	// its total flow
+	vector<IloRangeArray> node_rows;
+	IloRangeArray total_rows;
 };
 
-kMST_ILP::kMST_ILP( Instance& _instance, string _model_type, int _k ) :
-	instance( _instance ), model_type( _model_type ), k( _k )
+/* Publishes the best bound of this k and stops once the incumbent is known to
+ * be optimal from the lower bounds of smaller k. */
+ILOMIPINFOCALLBACK2(BoundSharingCallback, BoundTable *, bounds, int, k)
+{
+	bounds->offerLowerBound(k, getBestObjValue());
+	if (hasIncumbent() && getIncumbentObjValue() <= bounds->lowerBound(k) + 1e-6) {
+		abort();
+	}
+}
+
+/* Passes every new incumbent on to the checkpoint file, incumbent stream and
+ * bound table. An informational callback, unlike an incumbent callback, does
+ * not turn off dynamic search; it sees an incumbent at the next node. */
+ILOMIPINFOCALLBACK2(IncumbentCallback, kMST_ILP_Base *, ilp, Variables *, vars)
+{
+	if (!hasIncumbent() || !ilp->isNewIncumbent(getIncumbentObjValue())) {
+		return;
+	}
+
+	IloNumArray xvals(getEnv());
+	IloNumArray vvals(getEnv());
+	getIncumbentValues(xvals, vars->xs);
+	getIncumbentValues(vvals, vars->vs);
+	ilp->onIncumbent(xvals, vvals, getIncumbentObjValue(), getBestObjValue(), getNnodes(),
+			getCplexTime() - getStartTime());
+	xvals.end();
+	vvals.end();
+}
+
+/* Samples the progress of branch-and-bound into the telemetry buffer. */
+ILOMIPINFOCALLBACK1(TelemetryCallback, Telemetry *, telemetry)
+{
+	static const IloCplex::CutType cut_types[] = {
+		IloCplex::CutCover, IloCplex::CutGubCover, IloCplex::CutFlowCover, IloCplex::CutClique,
+		IloCplex::CutFrac, IloCplex::CutMir, IloCplex::CutFlowPath, IloCplex::CutDisj,
+		IloCplex::CutImplBd, IloCplex::CutZeroHalf, IloCplex::CutMCF
+	};
+
+	const double time = getCplexTime() - getStartTime();
+	if (!telemetry->claim(time)) {
+		return;
+	}
+
+	Telemetry::Sample sample;
+	sample.time = time;
+	sample.bound = getBestObjValue();
+	sample.incumbent = hasIncumbent() ? getIncumbentObjValue() : numeric_limits<double>::quiet_NaN();
+	sample.gap = hasIncumbent() ? getMIPRelativeGap() : numeric_limits<double>::quiet_NaN();
+	sample.nodes = getNnodes();
+	sample.open_nodes = getNremainingNodes();
+	sample.cuts = 0;
+	for (auto &type : cut_types) {
+		sample.cuts += getNcuts(type);
+	}
+	telemetry->push(sample);
+}
+
+/* Branches on the most fractional node variable, preferring nodes with a high
+ * static score, and explores the branch activating the node first. Leaves
+ * the decision to CPLEX (and the priorities) once all nodes are integral. */
+ILOBRANCHCALLBACK2(NodeBranchCallback, Variables *, vars, const vector<double> *, score)
+{
+	static const double EPS = 1e-6;
+
+	if (getBranchType() != BranchOnVariable) {
+		return;
+	}
+
+	IloNumArray vvals(getEnv());
+	getValues(vvals, vars->vs);
+
+	int best = -1;
+	double best_value = 0;
+	for (u_int i = 1; i < vvals.getSize(); i++) {
+		const double v = vvals[i];
+		if (v < EPS || v > 1 - EPS) {
+			continue;
+		}
+		const double value = min(v, 1 - v) * (1 + (*score)[i]);
+		if (value > best_value) {
+			best = i;
+			best_value = value;
+		}
+	}
+	vvals.end();
+
+	if (best < 0) {
+		return;
+	}
+	makeBranch(vars->vs[best], 1, IloCplex::BranchUp, getObjValue());
+	makeBranch(vars->vs[best], 0, IloCplex::BranchDown, getObjValue());
+}
+
+template <class Instance>
+kMST_ILP<Instance>::kMST_ILP( Instance& _instance, string _model_type, int _k, const Options& _options ) :
+	instance( _instance ), model_type( _model_type ), k( _k ), options( _options ),
+	vars( 0 ), log( _options.log ? _options.log : &cout ), incumbent_stream( 0 ),
+	last_incumbent( numeric_limits<double>::infinity() ), solve_start( 0 ), telemetry( 0 ), n_solves( 0 )
 {
 	n = instance.n_nodes;
 	m = instance.n_edges;
 	if( k == 0 ) k = n;
 }
 
-void kMST_ILP::solve()
+template <class Instance>
+int kMST_ILP<Instance>::solve()
 {
 	try {
 		// initialize CPLEX
 		env = IloEnv();
 		model = IloModel( env );
 
-		Variables *vars;
+		// only compare root bounds of formulations
+		if( model_type.compare( 0, 3, "lp:" ) == 0 ) return solveRootBounds();
+
+		// add model-specific constraints, or load them from the model cache
+		const double start = Tools::CPUtime();
+		const string cached = modelCachePath();
+		if( !cached.empty() && (vars = loadModel( cached )) ) {
+			*log << "Loaded model from " << cached << "\n";
+		} else {
+			vars = buildModel( model_type );
+			if( !vars ) {
+				cerr << "No existing model chosen\n";
+				return NO_SOLUTION;
+			}
 
-		// add model-specific constraints
-		if( model_type == "scf" ) vars = modelSCF();
-		else if( model_type == "mcf" ) vars = modelMCF();
-		else if( model_type == "mtz" ) vars = modelMTZ();
-		else {
-			cerr << "No existing model chosen\n";
-			exit( -1 );
+			// build model
+			extract();
+			if( !cached.empty() ) saveModel( cached );
 		}
-
-		// build model
-		cplex = IloCplex( model );
+		*log << "Build time: " << Tools::CPUtime() - start << "\n";
 		// export model to a text file
 		//cplex.exportModel( "model.lp" );
 		// set parameters
 		setCPLEXParameters();
+		setBranching();
+
+		// warm start from a stored (possibly nearby) solution
+		if( !options.mip_start.empty() ) {
+			Solution start;
+			if( start.read( options.mip_start, instance ) && start.repair( instance, k ) ) {
+				*log << "Using MIP start of weight " << start.weight << " from " << options.mip_start << "\n";
+				addMIPStart( vars, start );
+			} else {
+				cerr << "kMST_ILP: could not use MIP start " << options.mip_start << "\n";
+			}
+		}
+
+		// warm start from the best Prim k-tree
+		if( options.prim_start ) {
+			Solution start;
+			if( bestPrimKTree( instance, k, start.nodes ) < numeric_limits<double>::infinity()
+					&& start.repair( instance, k ) ) {
+				*log << "Using Prim k-tree start of weight " << start.weight << "\n";
+				addMIPStart( vars, start );
+			}
+		}
+
+		// stream incumbents as JSON lines
+		if( options.incumbents == "-" ) {
+			incumbent_stream = &cout;
+		} else if( !options.incumbents.empty() ) {
+			incumbent_file.open( options.incumbents.c_str() );
+			if( incumbent_file.fail() ) {
+				cerr << "kMST_ILP: could not open incumbent file " << options.incumbents << "\n";
+			} else {
+				incumbent_stream = &incumbent_file;
+			}
+		}
+		useIncumbentCallback();
+
+		// start from and cut off by the trees of neighbouring k
+		if( options.bounds ) useBoundTable();
+
+		optimize();
+	}
+	catch( IloException& e ) {
+		cerr << "kMST_ILP: exception " << e << "\n";
+	}
+	catch( bad_alloc& ) {
+		cerr << "kMST_ILP: out of memory.\n";
+	}
+	catch( ... ) {
+		cerr << "kMST_ILP: unknown exception.\n";
+	}
+
+	stopTelemetry();
+	return report();
+}
+
+/* Applies delta to the instance and to the model built by solve(), then
+ * solves again, starting from the previous solution. Changed weights only
+ * change objective coefficients, removed edges fix their arcs to 0 and added
+ * edges get new columns in the kept rows (see addEdges()). Only a model
+ * loaded from the cache, whose rows are not known, is rebuilt for added
+ * edges. */
+template <class Instance>
+int kMST_ILP<Instance>::update( const vector<EdgeDelta>& delta )
+{
+	if( !vars || !cplex.getImpl() ) {
+		cerr << "kMST_ILP: no model to update\n";
+		return NO_SOLUTION;
+	}
 
-		// solve model
-		cout << "Calling CPLEX solve ...\n";
-		cplex.solve();
-		cout << "CPLEX finished.\n\n";
-		cout << "CPLEX status: " << cplex.getStatus() << "\n";
-		cout << "Branch-and-Bound nodes: " << cplex.getNnodes() << "\n";
-		cout << "Objective value: " << cplex.getObjValue() << "\n";
-		cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+	try {
+		const double start = Tools::CPUtime();
+
+		Solution previous;
+		const IloAlgorithm::Status s = cplex.getStatus();
+		const bool have_previous = (s == IloAlgorithm::Optimal || s == IloAlgorithm::Feasible);
+		if( have_previous ) {
+			IloNumArray xvals( env );
+			IloNumArray vvals( env );
+			cplex.getValues( xvals, vars->xs );
+			cplex.getValues( vvals, vars->vs );
+			previous = extractSolution( xvals, vvals, cplex.getObjValue() );
+			xvals.end();
+			vvals.end();
+		}
+
+		const u_int old_m = m;
+		instance.apply( delta );
+		const bool added = (instance.n_edges != old_m);
+		if( added && !addEdges( old_m ) ) {
+			delete vars;
+			vars = 0;
+			cplex.end();
+			model.end();
+
+			m = instance.n_edges;
+			model = IloModel( env );
+			vars = buildModel( model_type );
+			extract();
+			setCPLEXParameters();
+			setBranching();
+			useIncumbentCallback();
+			*log << "Rebuilt model for " << delta.size() << " changes in " << Tools::CPUtime() - start << "\n";
+		} else {
+			for( auto& d : delta ) {
+				if( d.kind == EdgeDelta::ADD || d.edge >= m ) continue;
+				if( d.kind == EdgeDelta::WEIGHT ) {
+					const IloNum weight = instance.edges[d.edge].weight;
+					vars->objective.setLinearCoef( vars->xs[d.edge], weight );
+					vars->objective.setLinearCoef( vars->xs[d.edge + m], weight );
+				} else if( d.kind == EdgeDelta::REMOVE ) {
+					vars->xs[d.edge].setUB( 0 );
+					vars->xs[d.edge + m].setUB( 0 );
+				}
+			}
+			// priorities of the renumbered arcs
+			if( added ) setBranching( true );
+			*log << "Updated model for " << delta.size() << " changes in " << Tools::CPUtime() - start << "\n";
+		}
 
-		// vars->print(cplex);
+		// the previous tree, repaired if it lost an edge
+		if( have_previous && previous.repair( instance, k ) ) {
+			*log << "Using previous solution (now of weight " << previous.weight << ") as start\n";
+			addMIPStart( vars, previous );
+		}
 
-		delete vars;
+		optimize();
 	}
 	catch( IloException& e ) {
 		cerr << "kMST_ILP: exception " << e << "\n";
-		exit( -1 );
+	}
+	catch( bad_alloc& ) {
+		cerr << "kMST_ILP: out of memory.\n";
 	}
 	catch( ... ) {
 		cerr << "kMST_ILP: unknown exception.\n";
-		exit( -1 );
+	}
+
+	stopTelemetry();
+	return report();
+}
+
+/* Gives the edges from old_m on, added to the instance after the model was
+ * built, columns in the rows kept by the model. Arcs are renumbered as in
+ * ArcView: the reverse arcs of the old edges move up by the number
+ * of added edges. Returns false if the rows are not known. */
+template <class Instance>
+bool kMST_ILP<Instance>::addEdges( u_int old_m )
+{
+	if( !vars->edge_count.getImpl() ) return false;
+
+	m = instance.n_edges;
+	vector<int> from( 2 * m, -1 );
+	vector<u_int> tail( 2 * m ), head( 2 * m );
+	for( u_int a = 0; a < 2 * m; a++ ) {
+		const u_int e = a % m;
+		tail[a] = (a < m) ? instance.edges[e].v1 : instance.edges[e].v2;
+		head[a] = (a < m) ? instance.edges[e].v2 : instance.edges[e].v1;
+		if( e < old_m ) from[a] = (a < m) ? e : e + old_m;
+	}
+
+	// new edges never touch the artificial root (see BasicInstance::apply())
+	IloBoolVarArray xs( env );
+	for( u_int a = 0; a < 2 * m; a++ ) {
+		if( from[a] >= 0 ) {
+			xs.add( vars->xs[from[a]] );
+			continue;
+		}
+		IloBoolVar x( env, Tools::indicesToString( "x", tail[a], head[a] ).c_str() );
+		xs.add( x );
+		vars->objective.setLinearCoef( x, (IloNum) instance.edges[a % m].weight );
+		vars->edge_count.setLinearCoef( x, 1 );
+		vars->out_degree[tail[a]].setLinearCoef( x, -1 );
+		vars->degree[tail[a]].setLinearCoef( x, 1 );
+		vars->degree[head[a]].setLinearCoef( x, 1 );
+		vars->in_degree[head[a] - 1].setLinearCoef( x, 1 );
+		if( instance.removed[a % m] ) x.setUB( 0 );
+	}
+	vars->xs.end();
+	vars->xs = xs;
+	vars->addArcs( model, from, tail, head, k );
+	return true;
+}
+
+template <class Instance>
+Variables *kMST_ILP<Instance>::buildModel( string type )
+{
+	PerfCounters::Scope scope( "build_model" );
+	Variables *v = 0;
+	if( type == "scf" ) v = modelSCF();
+	else if( type == "mcf" ) v = modelMCF();
+	else if( type == "mtz" ) v = modelMTZ();
+	if( !v ) return 0;
+
+	// edges removed by a delta keep their columns, fixed to 0
+	for( u_int e = 0; e < m; e++ ) {
+		if( !instance.removed[e] ) continue;
+		v->xs[e].setUB( 0 );
+		v->xs[e + m].setUB( 0 );
+	}
+	return v;
+}
+
+/* Builds each requested formulation and solves only its root: the LP
+ * relaxation, or with options.root_cuts the root node including CPLEX cuts.
+ * Reports bound and size per formulation. */
+template <class Instance>
+int kMST_ILP<Instance>::solveRootBounds()
+{
+	vector<string> types;
+	const string which = model_type.substr( 3 );
+	if( which == "all" ) {
+		types.push_back( "scf" );
+		types.push_back( "mcf" );
+		types.push_back( "mtz" );
+	} else {
+		types.push_back( which );
+	}
+
+	*log << left << setw( 6 ) << "model" << right
+		<< setw( 14 ) << "bound"
+		<< setw( 10 ) << "build[s]"
+		<< setw( 10 ) << "solve[s]"
+		<< setw( 10 ) << "rows"
+		<< setw( 10 ) << "columns"
+		<< setw( 12 ) << "nonzeros" << "\n";
+
+	Status status = OPTIMAL;
+	for( u_int i = 0; i < types.size(); i++ ) {
+		if( i > 0 ) {
+			delete vars;
+			vars = 0;
+			cplex.end();
+			model.end();
+		}
+
+		model = IloModel( env );
+		const double start = Tools::CPUtime();
+		vars = buildModel( types[i] );
+		if( !vars ) {
+			cerr << "No existing model chosen\n";
+			return NO_SOLUTION;
+		}
+		if( !options.root_cuts ) vars->relax( model );
+		extract();
+		setCPLEXParameters();
+		cplex.setOut( env.getNullStream() );
+		if( options.root_cuts ) cplex.setParam( IloCplex::NodeLim, 0 );
+		const double built = Tools::CPUtime();
+
+		{
+			PerfCounters::Scope scope( "solve" );
+			cplex.solve();
+		}
+		const double solved = Tools::CPUtime();
+
+		*log << left << setw( 6 ) << types[i] << right << setw( 14 );
+		if( options.root_cuts ) {
+			*log << cplex.getBestObjValue();
+		} else if( cplex.getStatus() == IloAlgorithm::Optimal ) {
+			*log << cplex.getObjValue();
+		} else {
+			*log << cplex.getStatus();
+			status = NO_SOLUTION;
+		}
+		*log << setw( 10 ) << built - start
+			<< setw( 10 ) << solved - built
+			<< setw( 10 ) << cplex.getNrows()
+			<< setw( 10 ) << cplex.getNcols()
+			<< setw( 12 ) << cplex.getNNZs() << "\n";
+	}
+	*log << "CPU time: " << Tools::CPUtime() << "\n\n";
+	if( PerfCounters::enabled() ) PerfCounters::report( *log );
+
+	return status;
+}
+
+/* Prints status, objective, best bound and gap of the last solve, also if it
+ * was stopped by a limit or an exception, and writes the final solution. */
+template <class Instance>
+int kMST_ILP<Instance>::report()
+{
+	if( !vars || !cplex.getImpl() ) return NO_SOLUTION;
+
+	Status status = NO_SOLUTION;
+	try {
+		const IloAlgorithm::Status s = cplex.getStatus();
+		if( s == IloAlgorithm::Optimal ) status = OPTIMAL;
+		else if( s == IloAlgorithm::Feasible ) status = FEASIBLE;
+		// stopped by BoundSharingCallback: a smaller k proves optimality
+		if( status == FEASIBLE && options.bounds && cplex.getObjValue() <= options.bounds->lowerBound( k ) + 1e-6 ) {
+			*log << "Optimal by the bound of a smaller k\n";
+			status = OPTIMAL;
+		}
+
+		*log << "CPLEX status: " << s << " (" << cplex.getCplexStatus() << ")\n";
+		*log << "Branch-and-Bound nodes: " << cplex.getNnodes() << "\n";
+		if( status != NO_SOLUTION ) {
+			*log << "Objective value: " << cplex.getObjValue() << "\n";
+		}
+		*log << "Best bound: " << cplex.getBestObjValue() << "\n";
+		if( status != NO_SOLUTION ) {
+			*log << "Gap: " << cplex.getMIPRelativeGap() << "\n";
+		}
+		*log << "CPU time: " << Tools::CPUtime() << "\n";
+		*log << "Peak memory: " << Tools::peakMemory() << " MB\n\n";
+		if( PerfCounters::enabled() ) PerfCounters::report( *log );
+
+		if( status == NO_SOLUTION ) return status;
+		// the best bound, not the objective: an optimum is only proven up to
+		// the optimality tolerances
+		if( options.bounds ) options.bounds->offerLowerBound( k, cplex.getBestObjValue() );
+
+		if( options.print_variables ) vars->print( cplex );
+		const bool incumbents = !options.checkpoint.empty() || incumbent_stream;
+		if( !options.save_solution.empty() || options.bounds || incumbents ) {
+			IloNumArray xvals( env );
+			IloNumArray vvals( env );
+			cplex.getValues( xvals, vars->xs );
+			cplex.getValues( vvals, vars->vs );
+			// an incumbent found after the last call of IncumbentCallback
+			if( incumbents && isNewIncumbent( cplex.getObjValue() ) ) {
+				onIncumbent( xvals, vvals, cplex.getObjValue(), cplex.getBestObjValue(), cplex.getNnodes(),
+						cplex.getCplexTime() - solve_start );
+			}
+			const Solution solution = extractSolution( xvals, vvals, cplex.getObjValue() );
+			if( !options.save_solution.empty() ) solution.write( options.save_solution, instance );
+			if( options.bounds ) options.bounds->offerTree( k, solution );
+			xvals.end();
+			vvals.end();
+		}
+	}
+	catch( IloException& e ) {
+		cerr << "kMST_ILP: exception " << e << "\n";
+	}
+	return status;
+}
+
+template <class Instance>
+Solution kMST_ILP<Instance>::extractSolution( const IloNumArray& xvals, const IloNumArray& vvals, double weight ) const
+{
+	Solution solution;
+	solution.k = k;
+	solution.weight = weight;
+	for( u_int i = 1; i < n; i++ ) {
+		if( vvals[i] > 0.5 ) solution.nodes.push_back( i );
+	}
+	// arc a of ArcView belongs to edge a % m
+	for( u_int a = 0; a < xvals.getSize(); a++ ) {
+		if( xvals[a] > 0.5 ) solution.edges.push_back( a % m );
+	}
+	return solution;
+}
+
+template <class Instance>
+void kMST_ILP<Instance>::onIncumbent( const IloNumArray& xvals, const IloNumArray& vvals, double weight,
+		double bound, long bb_nodes, double time )
+{
+	lock_guard<mutex> lock( incumbent_mutex );
+
+	const Solution solution = extractSolution( xvals, vvals, weight );
+	if( options.bounds ) {
+		options.bounds->offerTree( k, solution );
+		options.bounds->offerLowerBound( k, bound );
+	}
+	if( !options.checkpoint.empty() ) {
+		solution.write( options.checkpoint, instance );
+	}
+	if( incumbent_stream ) {
+		// same definition of the relative gap as CPLEX
+		const double gap = fabs( weight - bound ) / (1e-10 + fabs( weight ));
+		// k tells the lines of a batch apart when they share stdout, each line
+		// is written at once so that they do not interleave
+		ostringstream line;
+		line << "{\"k\":" << k
+			<< ",\"time\":" << time
+			<< ",\"objective\":" << weight
+			<< ",\"bound\":" << bound
+			<< ",\"gap\":" << gap
+			<< ",\"bb_nodes\":" << bb_nodes
+			<< ",\"tree_nodes\":[";
+		for( u_int i = 0; i < solution.nodes.size(); i++ ) {
+			line << (i > 0 ? "," : "") << solution.nodes[i];
+		}
+		line << "]}\n";
+		*incumbent_stream << line.str() << flush;
 	}
 }
 
 // ----- private methods -----------------------------------------------
 
-void kMST_ILP::setCPLEXParameters()
+template <class Instance>
+bool kMST_ILP<Instance>::isNewIncumbent( double weight )
+{
+	lock_guard<mutex> lock( incumbent_mutex );
+	if( weight >= last_incumbent ) return false;
+	last_incumbent = weight;
+	return true;
+}
+
+template <class Instance>
+void kMST_ILP<Instance>::useIncumbentCallback()
+{
+	if( !options.checkpoint.empty() || incumbent_stream || options.bounds ) {
+		cplex.use( IncumbentCallback( env, this, vars ) );
+	}
+}
+
+/* The best tree known for k is at most as heavy as the one for k + 1, and
+ * the trees of k + 1 and k - 1 become starts after pruning or growing them
+ * by one node. */
+template <class Instance>
+void kMST_ILP<Instance>::useBoundTable()
+{
+	// the tree behind the cutoff is pruned to k nodes and used as start, so
+	// that an optimum equal to the cutoff is not lost
+	Solution start;
+	int j = options.bounds->upperTree( k, start );
+	if( j > 0 && start.repair( instance, k ) ) {
+		*log << "Using tree for k = " << j << " as start and upper cutoff " << start.weight << "\n";
+		addMIPStart( vars, start );
+		cplex.setParam( IloCplex::CutUp, start.weight );
+	}
+
+	// a tree for k - 1 grown by one node
+	if( options.bounds->tree( k - 1, start ) && start.repair( instance, k ) ) {
+		*log << "Using tree for k = " << k - 1 << " as start of weight " << start.weight << "\n";
+		addMIPStart( vars, start );
+	}
+
+	// bounds of smaller k only bound this one with non-negative weights
+	if( options.bounds->isMonotone() ) cplex.use( BoundSharingCallback( env, options.bounds, k ) );
+}
+
+/* Extracts the model into a new IloCplex. */
+template <class Instance>
+void kMST_ILP<Instance>::extract()
+{
+	PerfCounters::Scope scope( "extraction" );
+	cplex = IloCplex( model );
+}
+
+/* Solves the current model, sampling progress if requested. Telemetry of
+ * later solves (see update()) is appended to the same file. */
+template <class Instance>
+void kMST_ILP<Instance>::optimize()
+{
+	if( !options.telemetry.empty() ) {
+		telemetry = new Telemetry( options.telemetry, options.telemetry_interval, n_solves > 0 );
+		if( telemetry->isOpen() ) telemetry_callback = cplex.use( TelemetryCallback( env, telemetry ) );
+	}
+	n_solves++;
+	// incumbents of a changed model (see update()) may be heavier
+	last_incumbent = numeric_limits<double>::infinity();
+
+	// solve model
+	PerfCounters::Scope scope( "solve" );
+	*log << "Calling CPLEX solve ...\n";
+	const auto start = chrono::steady_clock::now();
+	solve_start = cplex.getCplexTime();
+	cplex.solve();
+	*log << "CPLEX finished.\n";
+	*log << "Solve time: " << chrono::duration<double>( chrono::steady_clock::now() - start ).count() << "\n\n";
+}
+
+/* Flushes the remaining samples before reporting. */
+template <class Instance>
+void kMST_ILP<Instance>::stopTelemetry()
+{
+	if( !telemetry ) return;
+
+	if( telemetry->isOpen() ) cplex.remove( telemetry_callback );
+	telemetry->close();
+	*log << "Telemetry samples: " << telemetry->written() << " (" << telemetry->dropped() << " dropped)\n";
+	delete telemetry;
+	telemetry = 0;
+}
+
+template <class Instance>
+void kMST_ILP<Instance>::setCPLEXParameters()
 {
 	// print every x-th line of node-log and give more details
-	cplex.setParam( IloCplex::MIPInterval, 1 );
-	cplex.setParam( IloCplex::MIPDisplay, 2 );
+	cplex.setParam( IloCplex::MIPInterval, options.mip_interval );
+	cplex.setParam( IloCplex::MIPDisplay, options.mip_display );
 	// only use a single thread
-	cplex.setParam( IloCplex::Threads, 0 );
+	cplex.setParam( IloCplex::Threads, options.threads );
+	if( log != &cout ) {
+		cplex.setOut( *log );
+		cplex.setWarning( *log );
+	}
+
+	if( !options.profile.empty() ) {
+		*log << "Using profile " << options.profile.name << ": " << options.profile.toString() << "\n";
+		options.profile.apply( cplex );
+	}
+
+	if( options.time_limit > 0 ) cplex.setParam( IloCplex::TiLim, options.time_limit );
+	if( options.gap >= 0 ) cplex.setParam( IloCplex::EpGap, options.gap );
+	if( !options.node_file_dir.empty() ) {
+		// compressed node files on disk
+		cplex.setParam( IloCplex::WorkDir, options.node_file_dir.c_str() );
+		cplex.setParam( IloCplex::NodeFileInd, 3 );
+	}
+	if( options.mem_limit > 0 ) {
+		// move nodes to node files once working memory exceeds the limit
+		cplex.setParam( IloCplex::WorkMem, options.mem_limit );
+		if( options.node_file_dir.empty() ) {
+			// without a disk to spill to, compress nodes in memory and stop
+			// cleanly before the tree outgrows the limit
+			cplex.setParam( IloCplex::NodeFileInd, 1 );
+			cplex.setParam( IloCplex::TreLim, options.mem_limit );
+		}
+	}
+}
+
+/* Static node score: nodes whose cheapest k - 1 incident edges are cheap on
+ * average come first, ties are broken by higher degree. Returns the score of
+ * each node in [0, 1] by rank, 1 for the best node and 0 for the root. */
+template <class Instance>
+static vector<double> nodeScores(const Instance &instance, u_int k)
+{
+	const u_int n = instance.n_nodes;
+
+	vector<double> cost(n, numeric_limits<double>::infinity());
+	vector<u_int> degree(n, 0);
+	for (u_int i = 1; i < n; i++) {
+		vector<double> weights;
+		for (auto &e : instance.incidentEdges[i]) {
+			const typename Instance::Edge &f = instance.edges[e];
+			if (f.v1 != 0 && f.v2 != 0) {
+				weights.push_back(f.weight);
+			}
+		}
+		degree[i] = weights.size();
+		const u_int cheapest = min<u_int>(weights.size(), k > 1 ? k - 1 : 1);
+		if (cheapest == 0) {
+			continue;
+		}
+		partial_sort(weights.begin(), weights.begin() + cheapest, weights.end());
+		cost[i] = accumulate(weights.begin(), weights.begin() + cheapest, 0.0) / cheapest;
+	}
+
+	vector<u_int> order;
+	for (u_int i = 1; i < n; i++) {
+		order.push_back(i);
+	}
+	sort(order.begin(), order.end(), [&](u_int a, u_int b) {
+			return cost[a] < cost[b] || (cost[a] == cost[b] && degree[a] > degree[b]); });
+
+	vector<double> score(n, 0);
+	for (u_int r = 0; r < order.size(); r++) {
+		score[order[r]] = 1 - (double) r / order.size();
+	}
+	return score;
 }
 
-/* Turns the given edge vector into a vector containing both the original
- * edges and their reverse directions. */
-static vector<Instance::Edge> directed_edges(const vector<Instance::Edge> &es)
+/* Branching priorities (higher first): arcs out of the artificial root, then
+ * node variables, then all other arcs, with nodes and root arcs ordered by
+ * nodeScores(). The callback variant also decides which fractional node to
+ * branch on at each B&B node. */
+template <class Instance>
+void kMST_ILP<Instance>::setBranching( bool renumbered )
 {
-	vector<Instance::Edge> des;
-	des.resize(es.size() * 2);
+	if (options.branching.empty()) {
+		return;
+	}
+	if (options.branching != "priorities" && options.branching != "callback") {
+		if (!renumbered) {
+			cerr << "kMST_ILP: unknown branching " << options.branching << ", using the CPLEX default\n";
+		}
+		return;
+	}
 
-	auto it = copy(es.cbegin(), es.cend(), des.begin());
-	transform(es.cbegin(), es.cend(), it, [](const Instance::Edge &e) {
-			Instance::Edge f = {e.v2, e.v1, e.weight}; return f; });
+	node_score = nodeScores(instance, k);
+
+	IloNumVarArray vs(env);
+	IloNumArray priorities(env);
+	for (u_int a = 0; a < 2 * m; a++) {
+		// arc a of ArcView has the endpoints of edge a % m
+		const typename Instance::Edge &e = instance.edges[a % m];
+		const u_int from = (a < m) ? e.v1 : e.v2;
+		const u_int to = (a < m) ? e.v2 : e.v1;
+		vs.add(vars->xs[a]);
+		priorities.add(from == 0 ? n + 1 + (int) ((n - 1) * node_score[to]) : 1);
+	}
+	for (u_int i = 1; i < n; i++) {
+		vs.add(vars->vs[i]);
+		priorities.add(2 + (int) ((n - 2) * node_score[i]));
+	}
+	cplex.setPriorities(vs, priorities);
+	vs.end();
+	priorities.end();
 
-	return des;
+	if (options.branching == "callback" && !renumbered) {
+		cplex.use(NodeBranchCallback(env, vars, &node_score));
+	}
+}
+
+/* Version of the model builders, part of the cache file names. Increase it
+ * whenever a formulation changes, so that stale cached models are not loaded. */
+static const int MODEL_VERSION = 2;
+
+/* Cache file of the current instance, model and k, empty without a cache. */
+template <class Instance>
+string kMST_ILP<Instance>::modelCachePath() const
+{
+	if( options.model_cache.empty() ) return "";
+
+	stringstream ss;
+	ss << options.model_cache << "/" << model_type << "-k" << k << "-v" << MODEL_VERSION << "-"
+		<< hex << setw( 16 ) << setfill( '0' ) << instance.hash() << ".sav";
+	return ss.str();
+}
+
+/* Imports a cached model into model and cplex, and finds the x and v
+ * variables by their names. Returns 0 if there is no usable cache file. */
+template <class Instance>
+Variables *kMST_ILP<Instance>::loadModel( string file )
+{
+	if( ifstream( file.c_str() ).fail() ) return 0;
+
+	CachedVariables *v = new CachedVariables();
+	IloNumVarArray variables( env );
+	IloRangeArray ranges( env );
+	try {
+		cplex = IloCplex( env );
+		cplex.importModel( model, file.c_str(), v->objective, variables, ranges );
+		PerfCounters::Scope scope( "extraction" );
+		cplex.extract( model );
+	}
+	catch( IloException& e ) {
+		cerr << "kMST_ILP: could not load model " << file << ": " << e << "\n";
+		delete v;
+		cplex.end();
+		model.end();
+		model = IloModel( env );
+		return 0;
+	}
+
+	map<string, u_int> index;
+	for( u_int i = 0; i < variables.getSize(); i++ ) {
+		index[variables[i].getName()] = i;
+	}
+
+	vector<bool> used( variables.getSize(), false );
+	bool complete = true;
+	auto take = [&]( string name ) {
+		const auto it = index.find( name );
+		if( it == index.end() || used[it->second] ) {
+			complete = false;
+			return IloBoolVar();
+		}
+		used[it->second] = true;
+		return IloBoolVar( variables[it->second].getImpl() );
+	};
+
+	// arc a of ArcView is edge a % m, reversed for a >= m
+	for( u_int a = 0; a < 2 * m && complete; a++ ) {
+		const typename Instance::Edge& e = instance.edges[a % m];
+		v->xs.add( (a < m) ? take( Tools::indicesToString( "x", e.v1, e.v2 ) )
+				: take( Tools::indicesToString( "x", e.v2, e.v1 ) ) );
+	}
+	for( u_int i = 0; i < n && complete; i++ ) {
+		v->vs.add( take( Tools::indicesToString( "v", i ) ) );
+	}
+	for( u_int i = 0; i < variables.getSize(); i++ ) {
+		if( !used[i] ) v->others.add( variables[i] );
+	}
+
+	variables.end();
+	ranges.end();
+	if( !complete ) {
+		cerr << "kMST_ILP: variables of " << file << " do not match the instance\n";
+		delete v;
+		cplex.end();
+		model.end();
+		model = IloModel( env );
+		return 0;
+	}
+	return v;
+}
+
+/* Writes the extracted model in binary form, replacing the file atomically.
+ * The temporary file is private to this process, so that concurrent runs
+ * sharing the cache do not write to the same file. */
+template <class Instance>
+void kMST_ILP<Instance>::saveModel( string file )
+{
+	stringstream tmp_ss;
+	tmp_ss << file.substr( 0, file.size() - 4 ) << "." << getpid() << ".tmp.sav";
+	const string tmp = tmp_ss.str();
+	try {
+		cplex.exportModel( tmp.c_str() );
+		if( rename( tmp.c_str(), file.c_str() ) != 0 ) {
+			cerr << "kMST_ILP: could not write model cache " << file << "\n";
+			remove( tmp.c_str() );
+			return;
+		}
+		*log << "Saved model to " << file << "\n";
+	}
+	catch( IloException& e ) {
+		cerr << "kMST_ILP: could not write model cache " << file << ": " << e << "\n";
+		remove( tmp.c_str() );
+	}
+}
+
+/* The arcs of the model as a view on the edges of an instance, without
+ * copying them: arc a < m is edge a, arc a >= m is edge a - m reversed. */
+template <class Edge>
+class ArcView
+{
+public:
+	ArcView(const vector<Edge> &_edges) : edges(_edges), m(_edges.size()) { }
+
+	Edge operator[](u_int a) const
+	{
+		if (a < m) {
+			return edges[a];
+		}
+		const Edge &e = edges[a - m];
+		Edge f = {e.v2, e.v1, e.weight};
+		return f;
+	}
+	u_int size() const { return 2 * m; }
+
+private:
+	const vector<Edge> &edges;
+	const u_int m;
+};
+
+/* Orients the edges of solution away from the artificial root 0. */
+template <class Instance>
+static RootedTree orientTree(const Instance &instance, const Solution &solution)
+{
+	const u_int n = instance.n_nodes;
+	const u_int m = instance.n_edges;
+
+	RootedTree t;
+	t.parent.assign(n, -1);
+	t.pred.assign(n, -1);
+	t.depth.assign(n, 0);
+	t.size.assign(n, 0);
+
+	vector<vector<u_int> > adjacent(n);
+	for (auto &e : solution.edges) {
+		adjacent[instance.edges[e].v1].push_back(e);
+		adjacent[instance.edges[e].v2].push_back(e);
+	}
+
+	vector<u_int> order(1, 0);
+	vector<bool> seen(n, false);
+	seen[0] = true;
+	for (u_int i = 0; i < order.size(); i++) {
+		const u_int v = order[i];
+		for (auto &e : adjacent[v]) {
+			const typename Instance::Edge &f = instance.edges[e];
+			const u_int u = (f.v1 == v) ? f.v2 : f.v1;
+			if (seen[u]) {
+				continue;
+			}
+			seen[u] = true;
+			/* ArcView keeps (v1, v2) at index e and (v2, v1) at e + m. */
+			const u_int a = (f.v1 == v) ? e : e + m;
+			t.arcs.push_back(a);
+			t.parent[u] = a;
+			t.pred[u] = v;
+			t.depth[u] = t.depth[v] + 1;
+			order.push_back(u);
+		}
+	}
+
+	for (u_int i = order.size(); i-- > 0; ) {
+		const u_int v = order[i];
+		t.size[v]++;
+		if (t.pred[v] >= 0) {
+			t.size[t.pred[v]] += t.size[v];
+		}
+	}
+
+	return t;
+}
+
+template <class Instance>
+void kMST_ILP<Instance>::addMIPStart( Variables *vars, const Solution& solution )
+{
+	const RootedTree tree = orientTree(instance, solution);
+
+	IloNumVarArray start(env);
+	IloNumArray vals(env);
+
+	vector<bool> active(2 * m, false);
+	for (auto &a : tree.arcs) {
+		active[a] = true;
+	}
+	for (u_int a = 0; a < 2 * m; a++) {
+		start.add(vars->xs[a]);
+		vals.add(active[a] ? 1 : 0);
+	}
+	for (u_int i = 0; i < n; i++) {
+		start.add(vars->vs[i]);
+		vals.add((i == 0 || tree.parent[i] >= 0) ? 1 : 0);
+	}
+	vars->addStart(tree, start, vals);
+
+	/* Let CPLEX repair starts that violate constraints of this model. */
+	cplex.addMIPStart(start, vals, IloCplex::MIPStartRepair);
+	start.end();
+	vals.end();
 }
 
 /* $x_{ij} \in \{0, 1\}$ variables denote whether edge (i, j) is active. */
-static IloBoolVarArray createVarArrayXs(IloEnv env, vector<Instance::Edge> edges, u_int n_edges)
+template <class Edge>
+static IloBoolVarArray createVarArrayXs(IloEnv env, const ArcView<Edge> &edges, u_int n_edges)
 {
 	IloBoolVarArray xs = IloBoolVarArray(env, n_edges);
 	for (u_int k = 0; k < n_edges; k++) {
@@ -137,14 +1082,14 @@ static IloBoolVarArray createVarArrayXs(IloEnv env, vector<Instance::Edge> edges
 
 
 /* $f_{ij} \in [0, k]$ variables denote the number of goods on edge (i, j). */
-static IloIntVarArray createVarArrayFs(IloEnv env,vector<Instance::Edge> edges, u_int n_edges)
-
+template <class Edge>
+static IloIntVarArray createVarArrayFs(IloEnv env,const ArcView<Edge> &edges, u_int n_edges, u_int k)
 {
 	IloIntVarArray fs = IloIntVarArray(env, n_edges);
-	for (u_int k = 0; k < n_edges; k++) {
-		const u_int i = edges[k].v1;
-		const u_int j = edges[k].v2;
-		fs[k] = IloIntVar(env, 0, k, Tools::indicesToString("f", i, j).c_str());
+	for (u_int m = 0; m < n_edges; m++) {
+		const u_int i = edges[m].v1;
+		const u_int j = edges[m].v2;
+		fs[m] = IloIntVar(env, 0, k, Tools::indicesToString("f", i, j).c_str());
 	}
 	return fs;
 }
@@ -167,21 +1112,26 @@ static IloBoolVarArray createVarArrayVs(IloEnv env, u_int n_nodes)
  * Objective function:
  * $\sum_{i, j} c_{ij} x_{ij}$ 
  */ 
-static void addObjectiveFunction(IloEnv env, IloModel model, IloBoolVarArray xs, vector<Instance::Edge> edges, u_int n_edges)
+template <class Edge>
+static IloObjective addObjectiveFunction(IloEnv env, IloModel model, IloBoolVarArray xs, const ArcView<Edge> &edges, u_int n_edges)
 {
 	IloExpr e_objective(env);
 	for (u_int m = 0; m < n_edges; m++) {
-		e_objective += xs[m] * edges[m].weight;
+		e_objective += xs[m] * (IloNum) edges[m].weight;
 	}
-	model.add(IloMinimize(env, e_objective));
+	IloObjective objective = IloMinimize(env, e_objective);
+	model.add(objective);
 	e_objective.end();
+	return objective;
 }
 
 /* 
  * $\sum_{i > 0} v_i = k$. Ensure that exactly k nodes are active. 
  */
-static void addConstraint_k_nodes_active(IloEnv env, IloModel model, IloBoolVarArray vs, Instance& instance, u_int k)
+template <class Instance>
+static void addConstraint_k_nodes_active(IloEnv env, IloModel model, IloBoolVarArray vs, const Instance& instance, u_int k)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExpr e_num_nodes(env);
 	for (u_int i = 1; i < instance.n_nodes; i++) {
 		e_num_nodes += vs[i];
@@ -194,8 +1144,10 @@ static void addConstraint_k_nodes_active(IloEnv env, IloModel model, IloBoolVarA
  * There are exactly k - 1 arcs not counting edges from the artificial root node 0.
  * $\sum_{i, j > 0} x_{ij} = k - 1$.  
  */
-static void addConstraint_k_minus_one_active_edges(IloEnv env, IloModel model, IloBoolVarArray xs, vector<Instance::Edge> edges, u_int n_edges, u_int k)
+template <class Edge>
+static IloRange addConstraint_k_minus_one_active_edges(IloEnv env, IloModel model, IloBoolVarArray xs, const ArcView<Edge> &edges, u_int n_edges, u_int k)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExpr e_num_edges(env);
 	for (u_int m = 0; m < n_edges; m++) {
 		const u_int i = edges[m].v1;
@@ -204,16 +1156,20 @@ static void addConstraint_k_minus_one_active_edges(IloEnv env, IloModel model, I
 			e_num_edges += xs[m];
 		}
 	}
-	model.add(e_num_edges == k - 1);
+	IloRange row = (e_num_edges == k - 1);
+	model.add(row);
 	e_num_edges.end();
+	return row;
 }
 
 /* 
  * Exactly one node is chosen as the tree root. 
  * $\sum_j x_{0j} = 1$. 
  */
-static void addConstraint_one_active_outgoing_arc_for_node_zero(IloEnv env, IloModel model, IloBoolVarArray xs, vector<Instance::Edge> edges, u_int n_edges)
+template <class Edge>
+static void addConstraint_one_active_outgoing_arc_for_node_zero(IloEnv env, IloModel model, IloBoolVarArray xs, const ArcView<Edge> &edges, u_int n_edges)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExpr e_single_root(env);
 	for (u_int m = 0; m < n_edges; m++) {
 		const u_int i = edges[m].v1;
@@ -229,8 +1185,10 @@ static void addConstraint_one_active_outgoing_arc_for_node_zero(IloEnv env, IloM
  * No arc leads back to the artificial root node 0. 
  * $\sum_i x_{i0} = 0$. 
  */
-static void addConstraint_no_active_incoming_arc_for_node_zero(IloEnv env, IloModel model, IloBoolVarArray xs, vector<Instance::Edge> edges, u_int n_edges)
+template <class Edge>
+static void addConstraint_no_active_incoming_arc_for_node_zero(IloEnv env, IloModel model, IloBoolVarArray xs, const ArcView<Edge> &edges, u_int n_edges)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExpr e_single_root(env);
 	for (u_int m = 0; m < n_edges; m++) {
 		const u_int j = edges[m].v2;
@@ -247,41 +1205,58 @@ static void addConstraint_no_active_incoming_arc_for_node_zero(IloEnv env, IloMo
  * TODO: A tighter bound is to take the sum of incoming goods - 1.
  * $\forall i: (k - 1)v_i \geq \sum_j (x_{ij})$. 
  */
-static void addConstraint_bound_on_outgoing_arcs(IloModel model, IloBoolVarArray vs, IloExprArray& e_out_degree, Instance& instance, int k)
+template <class Instance>
+static IloRangeArray addConstraint_bound_on_outgoing_arcs(IloModel model, IloBoolVarArray vs, IloExprArray& e_out_degree, const Instance& instance, int k)
 {
+	PerfCounters::Scope scope(__func__);
+	IloRangeArray rows(model.getEnv());
 	for (u_int i = 0; i < instance.n_nodes; i++) {
-		model.add(vs[i] * (k - 1) >= e_out_degree[i]);
+		rows.add(vs[i] * (k - 1) - e_out_degree[i] >= 0);
 	}
+	model.add(rows);
+	return rows;
 }
 
 /**
  * Active nodes have at least one active arc.
  * $\forall i:  v_i \leq \sum_j (x_{ij} + x{ji})$.
  */
-static void addConstraint_active_node_at_least_one_active_arc(IloModel model, IloBoolVarArray vs, IloExprArray& e_in_degree, IloExprArray& e_out_degree, Instance& instance)
+template <class Instance>
+static IloRangeArray addConstraint_active_node_at_least_one_active_arc(IloModel model, IloBoolVarArray vs, IloExprArray& e_in_degree, IloExprArray& e_out_degree, const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
+	IloRangeArray rows(model.getEnv());
 	for (u_int i = 0; i < instance.n_nodes; i++) {
-		model.add(vs[i] <= e_out_degree[i] + e_in_degree[i]); 
+		rows.add(e_out_degree[i] + e_in_degree[i] - vs[i] >= 0);
 	}
+	model.add(rows);
+	return rows;
 }
 
 /**
  * Exactly one incoming edge for an active node and none for an inactive node (omitting artificial root). 
  * $\forall j>0: \sum_i x_{ij} = v_j$. 
  */
-static void addConstraint_in_degree_one_for_active_node_zero_for_inactive(IloModel model, IloBoolVarArray vs, IloExprArray& e_in_degree, Instance& instance)
+template <class Instance>
+static IloRangeArray addConstraint_in_degree_one_for_active_node_zero_for_inactive(IloModel model, IloBoolVarArray vs, IloExprArray& e_in_degree, const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
+	IloRangeArray rows(model.getEnv());
 	for (u_int i = 1; i < instance.n_nodes; i++) {
-		model.add(e_in_degree[i] == vs[i]);
+		rows.add(e_in_degree[i] - vs[i] == 0);
 	}
+	model.add(rows);
+	return rows;
 }
 
 
 /**
  * Create expression for in-degree for each node.
  */  
-static IloExprArray createExprArray_in_degree(IloEnv env, vector<Instance::Edge> edges, u_int n_edges, IloBoolVarArray xs,  Instance& instance)
+template <class Instance>
+static IloExprArray createExprArray_in_degree(IloEnv env, const ArcView<typename Instance::Edge> &edges, u_int n_edges, IloBoolVarArray xs,  const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExprArray e_in_degree(env, instance.n_nodes);
 	for (u_int i = 0; i < instance.n_nodes; i++) {
 		e_in_degree[i] = IloExpr(env);
@@ -296,8 +1271,10 @@ static IloExprArray createExprArray_in_degree(IloEnv env, vector<Instance::Edge>
 /**
  * Create expression for out-degree for each node.
  */  
-static IloExprArray createExprArray_out_degree(IloEnv env, vector<Instance::Edge> edges, u_int n_edges, IloBoolVarArray xs, Instance& instance)
+template <class Instance>
+static IloExprArray createExprArray_out_degree(IloEnv env, const ArcView<typename Instance::Edge> &edges, u_int n_edges, IloBoolVarArray xs, const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExprArray e_out_degree(env, instance.n_nodes);
 	for (u_int i = 0; i < instance.n_nodes; i++) {
 		e_out_degree[i] = IloExpr(env);
@@ -315,8 +1292,10 @@ static IloExprArray createExprArray_out_degree(IloEnv env, vector<Instance::Edge
 /**
  * Create expression for in-flow for each node.
  */  
-static IloExprArray createExprArray_in_flow(IloEnv env, vector<Instance::Edge> edges, u_int n_edges, IloIntVarArray fs,  Instance& instance)
+template <class Instance>
+static IloExprArray createExprArray_in_flow(IloEnv env, const ArcView<typename Instance::Edge> &edges, u_int n_edges, IloIntVarArray fs,  const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExprArray expr(env, instance.n_nodes);
 	for (u_int i = 0; i < instance.n_nodes; i++) {
 		expr[i] = IloExpr(env);
@@ -331,8 +1310,10 @@ static IloExprArray createExprArray_in_flow(IloEnv env, vector<Instance::Edge> e
 /**
  * Create expression for out-flow for each node.
  */
-static IloExprArray createExprArray_out_flow(IloEnv env, vector<Instance::Edge> edges, u_int n_edges, IloIntVarArray fs, Instance& instance)
+template <class Instance>
+static IloExprArray createExprArray_out_flow(IloEnv env, const ArcView<typename Instance::Edge> &edges, u_int n_edges, IloIntVarArray fs, const Instance& instance)
 {
+	PerfCounters::Scope scope(__func__);
 	IloExprArray expr(env, instance.n_nodes);
 	for (u_int i = 0; i < instance.n_nodes; i++) {
 		expr[i] = IloExpr(env);
@@ -346,11 +1327,12 @@ static IloExprArray createExprArray_out_flow(IloEnv env, vector<Instance::Edge>
 
 
 
-Variables *kMST_ILP::modelSCF()
+template <class Instance>
+Variables *kMST_ILP<Instance>::modelSCF()
 {
 	SCFVariables *v = new SCFVariables();
 
-	const vector<Instance::Edge> edges = directed_edges(instance.edges);
+	const ArcView<typename Instance::Edge> edges(instance.edges);
 	const u_int n_edges = edges.size();
 
 	/* $x_{ij} \in \{0, 1\}$ variables denote whether edge (i, j) is active. */
@@ -360,10 +1342,10 @@ Variables *kMST_ILP::modelSCF()
 	v->vs = createVarArrayVs(env, instance.n_nodes);
 
 	/* add objective function */
-	addObjectiveFunction(env, model, v->xs, edges, n_edges);
+	v->objective = addObjectiveFunction(env, model, v->xs, edges, n_edges);
 
 	/* There are exactly k - 1 edges not counting edges from the artificial root node 0. */
-	addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
+	v->edge_count = addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
 
     /* Exactly one node is chosen as the tree root. */
 	addConstraint_one_active_outgoing_arc_for_node_zero(env,model,v->xs,edges,n_edges);
@@ -375,13 +1357,13 @@ Variables *kMST_ILP::modelSCF()
 	IloExprArray e_out_degree = createExprArray_out_degree(env, edges, n_edges, v->xs, instance);
 
 	/* Inactive nodes have no outgoing active edges, active ones at most k - 1. TODO: A tighter bound is to take the sum of incoming goods - 1.*/
-	addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
+	v->out_degree = addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
 
 	/* Active nodes have at least one active arc.*/
-	addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
+	v->degree = addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
 	
 	/* Exactly one incoming edge for an active node and none for an inactive node (omitting artificial root). */
- 	addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
+ 	v->in_degree = addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
 	
 	//note: position matters. Tried worse positions than this one 
 	/* $\sum_{i > 0} v_i = k$. Ensure that exactly k nodes are active. */
@@ -389,8 +1371,8 @@ Variables *kMST_ILP::modelSCF()
 	e_in_degree.endElements();
 	e_out_degree.endElements();
 
-	/* $f_{ij} \in [0, k - 1]$ variables denote the number of goods on edge (i, j). */
-	v->fs = createVarArrayFs(env, edges, n_edges);
+	/* $f_{ij} \in [0, k]$ variables denote the number of goods on edge (i, j). */
+	v->fs = createVarArrayFs(env, edges, n_edges, this->k);
 
 	IloExprArray e_in_flow = createExprArray_in_flow(env, edges, n_edges, v->fs, instance);
 	IloExprArray e_out_flow = createExprArray_out_flow(env, edges, n_edges, v->fs, instance);
@@ -399,14 +1381,16 @@ Variables *kMST_ILP::modelSCF()
 	 * Active nodes consume exactly 1 commodity, inactive nodes conserve flow.
 	 * $\forall i \neq 0: \sum_j (f_{ji} - f_{ij}) == v_i$ 
      */
+	v->flow = IloRangeArray(env);
 	for (u_int i = 0; i < instance.n_nodes; i++) {
 		if (i == 0){
 			/* Don't add a constraint for the artificial root. */
 		} else if (i > 0) {
 			/* outflow = inflow -1 for active nodes, same for inactive nodes. */
-			model.add(v->vs[i] == e_in_flow[i] - e_out_flow[i]);
+			v->flow.add(e_in_flow[i] - e_out_flow[i] - v->vs[i] == 0);
 		}
 	}
+	model.add(v->flow);
 	e_in_flow.endElements();
 	e_out_flow.endElements();
 
@@ -429,13 +1413,14 @@ Variables *kMST_ILP::modelSCF()
 	return v;
 }
 
-Variables *kMST_ILP::modelMCF()
+template <class Instance>
+Variables *kMST_ILP<Instance>::modelMCF()
 {
 	MCFVariables *v = new MCFVariables();
 
 	/***** generic part ***/
 
-	const vector<Instance::Edge> edges = directed_edges(instance.edges);
+	const ArcView<typename Instance::Edge> edges(instance.edges);
 	const u_int n_edges = edges.size();
 
 	/* $x_{ij} \in \{0, 1\}$ variables denote whether edge (i, j) is active. */
@@ -445,10 +1430,10 @@ Variables *kMST_ILP::modelMCF()
 	v->vs = createVarArrayVs(env, instance.n_nodes);
 
 	/* add objective function */
-	addObjectiveFunction(env, model, v->xs, edges, n_edges);
+	v->objective = addObjectiveFunction(env, model, v->xs, edges, n_edges);
 
 	/* There are exactly k - 1 edges not counting edges from the artificial root node 0. */
-	addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
+	v->edge_count = addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
 
     /* Exactly one node is chosen as the tree root. */
 	addConstraint_one_active_outgoing_arc_for_node_zero(env,model,v->xs,edges,n_edges);
@@ -460,13 +1445,13 @@ Variables *kMST_ILP::modelMCF()
 	IloExprArray e_out_degree = createExprArray_out_degree(env, edges, n_edges, v->xs, instance);
 
 	/* Inactive nodes have no outgoing active edges, active ones at most k - 1. TODO: A tighter bound is to take the sum of incoming goods - 1.*/
-	addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
+	v->out_degree = addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
 
 	/* Active nodes have at least one active arc.*/
-	addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
+	v->degree = addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
 	
 	/* Exactly one incoming edge for an active node and none for an inactive node (omitting artificial root). */
- 	addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
+ 	v->in_degree = addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
 	
 	//note: position matters. Tried worse positions than this one 
 	/* $\sum_{i > 0} v_i = k$. Ensure that exactly k nodes are active. */
@@ -477,155 +1462,113 @@ Variables *kMST_ILP::modelMCF()
 
     /***** MCF specific part ***/
 
-	/* $f^k_{ij} \in \{0, 1\}$ variables denote the flow on edge (i, j) for commodity k. */
-	for (u_int i = 0; i < instance.n_nodes; i++) {
-		v->fss.push_back(IloBoolVarArray(env, n_edges));
-	}
-	for (u_int k = 0; k < n_edges; k++) {
-		const u_int i = edges[k].v1;
-		const u_int j = edges[k].v2;
-		for (u_int l = 0; l < (u_int) instance.n_nodes; l++) {
-			v->fss[l][k] = IloBoolVar(env, Tools::indicesToString("f", l, i, j).c_str());
-		}
-	}
-	
-	/* 
-     * Each commodity l is generated once by the artificial root node if node l is active, not at all otherwise:
-	 * $\forall l \in \{1, \ldots, n\}: \sum_{j:j>0,(0,j) \in A} f^l_{0j} == v_l$ 
-     */
-	for (u_int c = 1; c < instance.n_nodes; c++){
-		IloExpr e_one_commodity(env);		
-		for (u_int m = 0; m < n_edges; m++) {
-			const u_int i = edges[m].v1;
-			const u_int j = edges[m].v2;
-			if (i == 0 && j > 0){
-				e_one_commodity += v->fss[c][m];	
-			}
-		} 
-		model.add(e_one_commodity == v->vs[c]);
-		e_one_commodity.end();
-	}
-
-	/* 
-     * The artifical root generates k commodities:
-     * $\forall l \in \{0,\ldots,n\}\sum_{j:j>0,(0,j) \in A} f^l_{0j} = k$. 
-     */
-    IloExpr e_root_generates_k(env);		
-	for (u_int c = 0; c < instance.n_nodes; c++){
-		for (u_int m = 0; m < n_edges; m++) {
-			const u_int i = edges[m].v1;
-			const u_int j = edges[m].v2;
-			if (i == 0 && j > 0){
-				e_root_generates_k += v->fss[c][m];	
-			}
-		} 
-	}
-	model.add(e_root_generates_k == this->k);   
-	e_root_generates_k.end();
-
-
 	/*
-     * No commodity is generated for the artificial root:
-     * $\forall i, j: f^0_{ij} = 0$. 
-     */ 
-	for (u_int m = 0; m < n_edges; m++) {
-		model.add(v->fss[0][m] == 0);
-	} 
-
-	/* 
-	 * Transmitted commodities end up at the target node:
-	 * $\forall l>0: \sum_i f^l_{il} = \sum_j f^l_{0j}$. (here: = v_l) 
-     */
-	for (u_int c = 1; c < (u_int) instance.n_nodes; c++){
-		IloExpr e_commodity_reaches_target(env);		
-		for (u_int m = 0; m < n_edges; m++) {
-			const u_int i = edges[m].v1;
-			const u_int j = edges[m].v2;
-			if (i != c && j == c){
-				e_commodity_reaches_target += v->fss[c][m];	
-			}
-		} 
-		model.add(e_commodity_reaches_target == v->vs[c]);
-		e_commodity_reaches_target.end();
-	}
-
-
-	/* 
-	 * Once reached, the commodity never leaves the target node:
-	 * $\forall l>0: \sum_j f^l_{lj} = 0$.  
-     */
-	for (u_int c = 1; c < (u_int) instance.n_nodes; c++){
-		IloExpr e_commodity_stays_at_target(env);		
+	 * $f^l_{ij} \in \{0, 1\}$ variables denote the flow on edge (i, j) for commodity l.
+	 * There is no commodity for the artificial root, and none flows into the root
+	 * or out of its target, so these variables are not created at all.
+	 */
+	v->fss.push_back(IloBoolVarArray(env));
+	v->arcs.push_back(vector<u_int>());
+	for (u_int c = 1; c < instance.n_nodes; c++) {
+		IloBoolVarArray fs(env);
+		vector<u_int> arcs;
 		for (u_int m = 0; m < n_edges; m++) {
 			const u_int i = edges[m].v1;
 			const u_int j = edges[m].v2;
-			if (i == c && j != c){
-				e_commodity_stays_at_target += v->fss[c][m];	
+			if (j == 0 || i == c) {
+				continue;
 			}
-		} 
-		model.add(e_commodity_stays_at_target == 0);
-		e_commodity_stays_at_target.end();
+			fs.add(IloBoolVar(env, Tools::indicesToString("f", c, i, j).c_str()));
+			arcs.push_back(m);
+		}
+		v->fss.push_back(fs);
+		v->arcs.push_back(arcs);
 	}
 
-
 	/*
-	 * Flow is conserved when not at target node. 
-	 * $\forall j, l s.t. j \neq l: \sum_i f^l_{ij} = \sum_i f^l_{ji}$. 
+	 * The rows of each commodity are collected in one pass over its arcs and
+	 * added at once. The total number of commodities generated by the root,
+	 * $\sum_l \sum_j f^l_{0j} = k$, follows from the first row and
+	 * $\sum_l v_l = k$ and is left out.
 	 */
-	 for (u_int c = 0; c < (u_int) instance.n_nodes; c++){
-		IloExprArray e_in_flow(env, instance.n_nodes);		
-		IloExprArray e_out_flow(env, instance.n_nodes);		
-		for (u_int m = 0; m < instance.n_nodes; m++){
+	v->node_rows.push_back(IloRangeArray(env));
+	v->total_rows = IloRangeArray(env, instance.n_nodes);
+	for (u_int c = 1; c < instance.n_nodes; c++) {
+		const IloIntVarArray &fs = v->fss[c];
+		const vector<u_int> &arcs = v->arcs[c];
+
+		IloRangeArray rows(env);
+		IloRangeArray node_rows(env, instance.n_nodes - 1);
+		IloExprArray e_in_flow(env, instance.n_nodes);
+		IloExprArray e_out_flow(env, instance.n_nodes);
+		for (u_int m = 0; m < instance.n_nodes; m++) {
 			e_in_flow[m] = IloExpr(env);
 			e_out_flow[m] = IloExpr(env);
 		}
-		for (u_int m = 0; m < n_edges; m++) {
-			const u_int i = edges[m].v1;
-			const u_int j = edges[m].v2;
-			e_out_flow[i] += v->fss[c][m];	
-			e_in_flow[j] += v->fss[c][m];	
-		} 
-		for (u_int m = 1; m < instance.n_nodes; m++){
+		IloExpr e_total_flow(env);
+		for (u_int a = 0; a < arcs.size(); a++) {
+			e_out_flow[edges[arcs[a]].v1] += fs[a];
+			e_in_flow[edges[arcs[a]].v2] += fs[a];
+			e_total_flow += fs[a];
+
+			/*
+			 * Commodities may only be transmitted on active edges:
+			 * $\forall l, i, j: f^l_{ij} \leq x_{ij}$.
+			 * These stay disaggregated, summing them over l or over the arcs of
+			 * a node weakens the LP relaxation to that of the SCF model.
+			 */
+			rows.add(fs[a] <= v->xs[arcs[a]]);
+		}
+
+		/*
+		 * Each commodity l is generated once by the artificial root node if node l is active, not at all otherwise:
+		 * $\sum_{j:j>0,(0,j) \in A} f^l_{0j} == v_l$
+		 */
+		rows.add(e_out_flow[0] == v->vs[c]);
+
+		/*
+		 * Transmitted commodities end up at the target node:
+		 * $\sum_i f^l_{il} = v_l$.
+		 */
+		node_rows[c - 1] = (e_in_flow[c] - v->vs[c] == 0);
+		rows.add(node_rows[c - 1]);
+
+		/*
+		 * Flow is conserved when not at target node.
+		 * $\forall j \neq l: \sum_i f^l_{ij} = \sum_i f^l_{ji}$.
+		 */
+		for (u_int m = 1; m < instance.n_nodes; m++) {
 			if (m != c) {
-				model.add(e_in_flow[m] == e_out_flow[m]);
+				node_rows[m - 1] = (e_in_flow[m] - e_out_flow[m] == 0);
+				rows.add(node_rows[m - 1]);
 			}
 		}
-		e_in_flow.endElements();
-		e_out_flow.endElements();
-	 }
 
-	/* 
-	 * Commodities may only be transmitted on active edges:
-	 * $\forall l, i, j: f^l_{ij} \leq x_{ij}$. 
-     */
-	for (u_int c = 0; c < (u_int) instance.n_nodes; c++){
-		for (u_int m = 0; m < n_edges; m++) {
-			model.add(v->fss[c][m] <= v->xs[m]);
-		} 
-	}
+		/*
+		 * For each commodity l , the total flow is <= k if node l is active, 0 otherwise
+		 * (works well for all before g05, k=n/2 which is a bit slower with this)
+		 */
+		v->total_rows[c] = (e_total_flow - this->k * v->vs[c] <= 0);
+		rows.add(v->total_rows[c]);
 
-	/* 
-	 * For each commodity l , the total flow is <= k if node l is active, 0 otherwise
-	 * (works well for all before g05, k=n/2 which is a bit slower with this)
-     */
-	for (u_int c = 1; c < (u_int) instance.n_nodes; c++){
-		IloExpr e_total_flow(env);		
-		for (u_int m = 0; m < n_edges; m++) {
-			e_total_flow += v->fss[c][m];	
-		} 
-		model.add(e_total_flow <= this->k * v->vs[c]);
+		model.add(rows);
+		v->node_rows.push_back(node_rows);
+		e_in_flow.endElements();
+		e_out_flow.endElements();
 		e_total_flow.end();
+		rows.end();
 	}
 	return v;
 }
 
-Variables *kMST_ILP::modelMTZ()
+template <class Instance>
+Variables *kMST_ILP<Instance>::modelMTZ()
 {
 	MTZVariables *v = new MTZVariables();
 
     /***** generic part ***/
 
-	const vector<Instance::Edge> edges = directed_edges(instance.edges);
+	const ArcView<typename Instance::Edge> edges(instance.edges);
 	const u_int n_edges = edges.size();
 
 	/* $x_{ij} \in \{0, 1\}$ variables denote whether edge (i, j) is active. */
@@ -635,10 +1578,10 @@ Variables *kMST_ILP::modelMTZ()
 	v->vs = createVarArrayVs(env, instance.n_nodes);
 
 	/* add objective function */
-	addObjectiveFunction(env, model, v->xs, edges, n_edges);
+	v->objective = addObjectiveFunction(env, model, v->xs, edges, n_edges);
 
 	/* There are exactly k - 1 edges not counting edges from the artificial root node 0. */
-	addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
+	v->edge_count = addConstraint_k_minus_one_active_edges(env,model,v->xs,edges,n_edges,this->k);
 
     /* Exactly one node is chosen as the tree root. */
 	addConstraint_one_active_outgoing_arc_for_node_zero(env,model,v->xs,edges,n_edges);
@@ -650,13 +1593,13 @@ Variables *kMST_ILP::modelMTZ()
 	IloExprArray e_out_degree = createExprArray_out_degree(env, edges, n_edges, v->xs, instance);
 
 	/* Inactive nodes have no outgoing active edges, active ones at most k - 1. TODO: A tighter bound is to take the sum of incoming goods - 1.*/
-	addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
+	v->out_degree = addConstraint_bound_on_outgoing_arcs(model,v->vs,e_out_degree,instance,this->k);
 
 	/* Active nodes have at least one active arc.*/
-	addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
+	v->degree = addConstraint_active_node_at_least_one_active_arc(model,v->vs,e_in_degree, e_out_degree,instance);
 	
 	/* Exactly one incoming edge for an active node and none for an inactive node (omitting artificial root). */
- 	addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
+ 	v->in_degree = addConstraint_in_degree_one_for_active_node_zero_for_inactive(model,v->vs,e_in_degree,instance);
 	
 	//note: position matters. Tried worse positions than this one 
 	/* $\sum_{i > 0} v_i = k$. Ensure that exactly k nodes are active. */
@@ -700,15 +1643,19 @@ Variables *kMST_ILP::modelMTZ()
 	return v;
 }
 
-kMST_ILP::~kMST_ILP()
+template <class Instance>
+kMST_ILP<Instance>::~kMST_ILP()
 {
+	delete vars;
+	delete telemetry;
 	// free global CPLEX resources
 	cplex.end();
 	model.end();
 	env.end();
 }
 
-static void print_values(IloCplex &cplex, const IloIntVarArray *xs)
+template <class Array>
+static void print_values(IloCplex &cplex, const Array *xs)
 {
 	for (u_int i = 0; i < xs->getSize(); i++) {
 		const int v = cplex.getValue((*xs)[i]);
@@ -719,11 +1666,34 @@ static void print_values(IloCplex &cplex, const IloIntVarArray *xs)
 	}
 }
 
+CachedVariables::~CachedVariables()
+{
+	xs.end();
+	vs.end();
+	others.end();
+}
+
+void CachedVariables::print(IloCplex &cplex)
+{
+	print_values(cplex, &xs);
+	print_values(cplex, &vs);
+	print_values(cplex, &others);
+}
+
+void CachedVariables::relax(IloModel model)
+{
+	Variables::relax(model);
+	model.add(IloConversion(model.getEnv(), others, ILOFLOAT));
+}
+
 MTZVariables::~MTZVariables()
 {
 	xs.end();
 	vs.end();
 	us.end();
+	out_degree.end();
+	degree.end();
+	in_degree.end();
 }
 
 void MTZVariables::print(IloCplex &cplex)
@@ -733,11 +1703,41 @@ void MTZVariables::print(IloCplex &cplex)
 	print_values(cplex, &us);
 }
 
+/* $u_i$ is the depth of node i in the tree. */
+void MTZVariables::relax(IloModel model)
+{
+	Variables::relax(model);
+	model.add(IloConversion(model.getEnv(), us, ILOFLOAT));
+}
+
+void MTZVariables::addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals)
+{
+	for (u_int i = 0; i < us.getSize(); i++) {
+		vars.add(us[i]);
+		vals.add(tree.depth[i]);
+	}
+}
+
+/* $u_i + x_{ij} \leq u_j + (1 - x_{ij})k$ for each new arc. */
+void MTZVariables::addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+		const vector<u_int> &head, int k)
+{
+	for (u_int a = 0; a < from.size(); a++) {
+		if (from[a] < 0) {
+			model.add(us[tail[a]] + xs[a] - us[head[a]] - (-xs[a] + 1) * k <= 0);
+		}
+	}
+}
+
 SCFVariables::~SCFVariables()
 {
 	xs.end();
 	vs.end();
 	fs.end();
+	flow.end();
+	out_degree.end();
+	degree.end();
+	in_degree.end();
 }
 
 void SCFVariables::print(IloCplex &cplex)
@@ -747,6 +1747,50 @@ void SCFVariables::print(IloCplex &cplex)
 	print_values(cplex, &fs);
 }
 
+/* $f_{ij}$ is the number of nodes below arc (i, j). */
+void SCFVariables::relax(IloModel model)
+{
+	Variables::relax(model);
+	model.add(IloConversion(model.getEnv(), fs, ILOFLOAT));
+}
+
+void SCFVariables::addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals)
+{
+	const u_int n_edges = fs.getSize();
+	vector<int> flow(n_edges, 0);
+	for (u_int i = 0; i < tree.parent.size(); i++) {
+		if (tree.parent[i] >= 0) {
+			flow[tree.parent[i]] = tree.size[i];
+		}
+	}
+	for (u_int a = 0; a < n_edges; a++) {
+		vars.add(fs[a]);
+		vals.add(flow[a]);
+	}
+}
+
+/* A new arc (i, j) has $f_{ij} \leq kx_{ij}$ and enters the flow conservation
+ * rows of i and j. */
+void SCFVariables::addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+		const vector<u_int> &head, int k)
+{
+	IloEnv env = model.getEnv();
+	IloIntVarArray moved(env);
+	for (u_int a = 0; a < from.size(); a++) {
+		if (from[a] >= 0) {
+			moved.add(fs[from[a]]);
+			continue;
+		}
+		IloIntVar f(env, 0, k, Tools::indicesToString("f", tail[a], head[a]).c_str());
+		moved.add(f);
+		flow[head[a] - 1].setLinearCoef(f, 1);
+		flow[tail[a] - 1].setLinearCoef(f, -1);
+		model.add(f <= k * xs[a]);
+	}
+	fs.end();
+	fs = moved;
+}
+
 MCFVariables::~MCFVariables()
 {
 	xs.end();
@@ -755,6 +1799,13 @@ MCFVariables::~MCFVariables()
 	for (auto &fs : fss) {
 		fs.end();
 	}
+	for (auto &rows : node_rows) {
+		rows.end();
+	}
+	total_rows.end();
+	out_degree.end();
+	degree.end();
+	in_degree.end();
 }
 
 void MCFVariables::print(IloCplex &cplex)
@@ -767,4 +1818,71 @@ void MCFVariables::print(IloCplex &cplex)
 	}
 }
 
+/* $f^l_{ij}$ is 1 iff arc (i, j) lies on the path from the root to l. */
+void MCFVariables::relax(IloModel model)
+{
+	Variables::relax(model);
+	for (auto &fs : fss) {
+		model.add(IloConversion(model.getEnv(), fs, ILOFLOAT));
+	}
+}
+
+void MCFVariables::addStart(const RootedTree &tree, IloNumVarArray &vars, IloNumArray &vals)
+{
+	const u_int n_edges = xs.getSize();
+	for (u_int l = 1; l < fss.size(); l++) {
+		vector<bool> on_path(n_edges, false);
+		for (int v = l; v > 0 && tree.parent[v] >= 0; v = tree.pred[v]) {
+			on_path[tree.parent[v]] = true;
+		}
+		for (u_int a = 0; a < arcs[l].size(); a++) {
+			vars.add(fss[l][a]);
+			vals.add(on_path[arcs[l][a]] ? 1 : 0);
+		}
+	}
+}
+
+/* A new arc (i, j) gets a flow variable $f^l_{ij} \leq x_{ij}$ for every
+ * commodity l except i, which enters the rows of l for i and j and its total. */
+void MCFVariables::addArcs(IloModel model, const vector<int> &from, const vector<u_int> &tail,
+		const vector<u_int> &head, int)
+{
+	IloEnv env = model.getEnv();
+	vector<u_int> position(from.size());
+	for (u_int a = 0; a < from.size(); a++) {
+		if (from[a] >= 0) {
+			position[from[a]] = a;
+		}
+	}
+	for (u_int l = 1; l < fss.size(); l++) {
+		for (auto &a : arcs[l]) {
+			a = position[a];
+		}
+	}
+
+	for (u_int a = 0; a < from.size(); a++) {
+		if (from[a] >= 0) {
+			continue;
+		}
+		const u_int i = tail[a];
+		const u_int j = head[a];
+		for (u_int l = 1; l < fss.size(); l++) {
+			if (i == l) {
+				continue;
+			}
+			IloBoolVar f(env, Tools::indicesToString("f", l, i, j).c_str());
+			fss[l].add(f);
+			arcs[l].push_back(a);
+			node_rows[l][j - 1].setLinearCoef(f, 1);
+			node_rows[l][i - 1].setLinearCoef(f, -1);
+			total_rows[l].setLinearCoef(f, 1);
+			model.add(f <= xs[a]);
+		}
+	}
+}
+
+#define INSTANTIATE( Index, Weight ) template class kMST_ILP<BasicInstance<Index, Weight> >;
+KMST_INSTANCE_TYPES( INSTANTIATE )
+#undef INSTANTIATE
+
 /* vim: set noet ts=4 sw=4: */
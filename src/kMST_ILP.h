@@ -2,8 +2,13 @@
 #define __K_MST_ILP__H__
 
 #include <ilcplex/ilocplex.h>
+#include <mutex>
 
+#include "BoundTable.h"
 #include "Instance.h"
+#include "Profile.h"
+#include "Solution.h"
+#include "Telemetry.h"
 #include "Tools.h"
 
 using namespace std;
@@ -12,7 +17,82 @@ ILOSTLBEGIN
 
 class Variables;
 
-class kMST_ILP
+/* Options and the callback interface shared by all instantiations of
+ * kMST_ILP, so that neither depend on the instance representation. */
+class kMST_ILP_Base
+{
+
+public:
+
+	struct Options
+	{
+		// write the final tree to this file
+		string save_solution;
+		// read a (possibly nearby) solution from this file as MIP start
+		string mip_start;
+		// write every new incumbent to this file
+		string checkpoint;
+		// dump non-zero variable values after solving
+		bool print_variables;
+		// stream every new incumbent as a JSON line to this file ("-" for stdout)
+		string incumbents;
+		// limits: seconds (TiLim, wall clock with the default ClockType),
+		// memory in MB (0 for none), relative MIP gap
+		// (negative for the CPLEX default)
+		double time_limit;
+		double mem_limit;
+		double gap;
+		// directory for CPLEX node files
+		string node_file_dir;
+		// in lp:<model> mode, solve the root node with cuts instead of the LP
+		bool root_cuts;
+		// use the best Prim k-tree (see DenseGraph) as MIP start
+		bool prim_start;
+		// sample progress every telemetry_interval seconds into this file
+		string telemetry;
+		double telemetry_interval;
+		// CPLEX node log: detail level (0 for none) and every how many nodes
+		int mip_display;
+		int mip_interval;
+		// "priorities": branch on root arcs, then nodes, then the other arcs;
+		// "callback": additionally pick the node to branch on by LP value
+		// and node score; empty for the CPLEX default
+		string branching;
+		// directory of extracted models (SAV files) by instance, model and k
+		string model_cache;
+		// CPLEX threads, 0 for automatic
+		int threads;
+		// output of the solver and CPLEX (cout if not set)
+		ostream *log;
+		// bounds and trees shared with solves for other k (see kMST_Batch)
+		BoundTable *bounds;
+		// tuned CPLEX search parameters (see kmst-tune), empty for defaults
+		Profile profile;
+
+		Options() :
+			print_variables( false ), time_limit( 0 ), mem_limit( 0 ), gap( -1 ),
+			root_cuts( false ), prim_start( false ), telemetry_interval( 1 ),
+			mip_display( 2 ), mip_interval( 1 ), threads( 0 ), log( 0 ), bounds( 0 ) { }
+	};
+
+	// result of solve(), also used as exit code
+	enum Status { OPTIMAL = 0, FEASIBLE = 1, NO_SOLUTION = 2 };
+
+	virtual ~kMST_ILP_Base() { }
+	virtual int solve() = 0;
+
+	// true once for each improving incumbent weight, see IncumbentCallback
+	virtual bool isNewIncumbent( double weight ) = 0;
+	// called by CPLEX for every new incumbent
+	virtual void onIncumbent( const IloNumArray& xvals, const IloNumArray& vvals, double weight,
+			double bound, long bb_nodes, double time ) = 0;
+
+};
+// kMST_ILP_Base
+
+/* The ILP models for an instance type (see BasicInstance). */
+template <class Instance>
+class kMST_ILP : public kMST_ILP_Base
 {
 
 private:
@@ -21,26 +101,72 @@ private:
 	Instance& instance;
 	string model_type;
 	int k;
+	Options options;
 	// number of edges and nodes including root node and root edges
 	unsigned int m, n;
 
 	IloEnv env;
 	IloModel model;
 	IloCplex cplex;
-
+	Variables *vars;
+
+	ostream *log;
+
+	// incumbent stream
+	ostream *incumbent_stream;
+	ofstream incumbent_file;
+	mutex incumbent_mutex;
+	// weight of the last incumbent passed to onIncumbent()
+	double last_incumbent;
+	// getCplexTime() at the start of the last solve, the clock of incumbents
+	double solve_start;
+
+	// progress samples, only while solving
+	Telemetry *telemetry;
+	IloCplex::Callback telemetry_callback;
+	// number of calls to optimize()
+	int n_solves;
+
+	// static branching score of each node in [0, 1], higher is branched first
+	vector<double> node_score;
+
+	Variables *buildModel( string type );
+	bool addEdges( unsigned int old_m );
 	Variables *modelSCF();
 	Variables *modelMCF();
 	Variables *modelMTZ();
 
 public:
 
-	kMST_ILP( Instance& _instance, string _model_type, int _k );
+	kMST_ILP( Instance& _instance, string _model_type, int _k, const Options& _options = Options() );
 	~kMST_ILP();
-	void solve();
+	int solve();
+	// apply changes to the instance and the model of the last solve() and
+	// solve again from the previous solution
+	int update( const vector<EdgeDelta>& delta );
+
+	// turn values of the x and v variables into a solution
+	Solution extractSolution( const IloNumArray& xvals, const IloNumArray& vvals, double weight ) const;
+	bool isNewIncumbent( double weight );
+	void onIncumbent( const IloNumArray& xvals, const IloNumArray& vvals, double weight,
+			double bound, long bb_nodes, double time );
 
 private:
 
 	void setCPLEXParameters();
+	// renumbered: only update the priorities after addEdges()
+	void setBranching( bool renumbered = false );
+	string modelCachePath() const;
+	Variables *loadModel( string file );
+	void saveModel( string file );
+	void useIncumbentCallback();
+	void useBoundTable();
+	void extract();
+	void optimize();
+	void stopTelemetry();
+	int solveRootBounds();
+	int report();
+	void addMIPStart( Variables *vars, const Solution& solution );
 
 };
 // kMST_ILP
@@ -26,6 +26,8 @@ if __name__ == "__main__":
     parser = OptionParser()
     parser.add_option("-m", "--model", dest = "models",
             help = "One of ['mtz', 'mcf', 'scf']", action = "append")
+    parser.add_option("-b", "--batch", dest = "batch", action = "store_true", default = False,
+            help = "Also solve all k of an instance in one --batch run")
     (options, args) = parser.parse_args()
 
     if options.models:
@@ -42,14 +44,17 @@ if __name__ == "__main__":
     failed = 0
     for meth in options.models:
         for inst in INSTANCES:
-            output = subprocess.check_output([BIN, "-f", DATADIR + inst[0],
-                                              "-m", meth, "-k", str(inst[1])])
+            # the exit code is the solve status, non-optimal runs fail below
+            process = subprocess.Popen([BIN, "-f", DATADIR + inst[0],
+                                        "-m", meth, "-k", str(inst[1])],
+                                       stdout = subprocess.PIPE)
+            output = process.communicate()[0]
             total += 1
 
             command = "%s -f %s -m %s -k %d" % (BIN, DATADIR + inst[0], meth, inst[1])
             match = pattern.search(output)
             if not match:
-                print "'%s' failed. No result" % command
+                print "'%s' failed. No result (exit code %d)" % (command, process.returncode)
                 failed += 1
                 continue
 
@@ -61,5 +66,37 @@ if __name__ == "__main__":
             else:
                 print "'%s' OK in %.2f s." % (command, duration)
 
+    if options.batch:
+        # rows of the summary table "k objective bound status wall time"
+        row_pattern = re.compile("^(\d+)\t(\S+)\t(\S+)\t(\w+)\t(\S+)$", re.MULTILINE)
+        files = []
+        for inst in INSTANCES:
+            if inst[0] not in files:
+                files.append(inst[0])
+
+        for meth in options.models:
+            for f in files:
+                expected = dict((inst[1], inst[2]) for inst in INSTANCES if inst[0] == f)
+                ks = ",".join(str(k) for k in sorted(expected))
+                command = "%s -f %s -m %s --batch %s" % (BIN, DATADIR + f, meth, ks)
+                process = subprocess.Popen([BIN, "-f", DATADIR + f, "-m", meth, "--batch", ks],
+                                           stdout = subprocess.PIPE)
+                output = process.communicate()[0]
+
+                rows = dict((int(r[0]), r) for r in row_pattern.findall(output))
+                for k in sorted(expected):
+                    total += 1
+                    if k not in rows or rows[k][1] == "-":
+                        print "'%s' failed for k = %d. No result (exit code %d)" % (command, k, process.returncode)
+                        failed += 1
+                        continue
+
+                    actual = int(round(float(rows[k][1])))
+                    if actual != expected[k] or rows[k][3] != "optimal":
+                        print "'%s' failed for k = %d. Expected %d, got %d (%s)" % (command, k, expected[k], actual, rows[k][3])
+                        failed += 1
+                    else:
+                        print "'%s' OK for k = %d in %.2f s." % (command, k, float(rows[k][4]))
+
     print "%d total, %d failed" % (total, failed)
 
@@ -23,7 +23,7 @@ INSTANCES = [ ["g01.dat", 2, 46]
             , ["g08.dat", 200, 5787]
             ]
 
-METHODS = ["mtz", "mcf", "scf"]
+METHODS = ["mtz", "mcf", "scf", "auto"]
 
 BIN = "./kmst"
 DATADIR = "data/"
@@ -31,7 +31,7 @@ DATADIR = "data/"
 if __name__ == "__main__":
     parser = OptionParser()
     parser.add_option("-m", "--model", dest = "models",
-            help = "One of ['mtz', 'mcf', 'scf']", action = "append")
+            help = "One of %s" % METHODS, action = "append")
     (options, args) = parser.parse_args()
 
     if options.models:
@@ -49,14 +49,17 @@ if __name__ == "__main__":
     failed = 0
     for meth in options.models:
         for inst in INSTANCES:
-            output = subprocess.check_output([BIN, "-f", DATADIR + inst[0],
-                                              "-m", meth, "-k", str(inst[1])])
+            # the exit code is the solve status, non-optimal runs fail below
+            process = subprocess.Popen([BIN, "-f", DATADIR + inst[0],
+                                        "-m", meth, "-k", str(inst[1])],
+                                       stdout = subprocess.PIPE)
+            output = process.communicate()[0]
             total += 1
 
             command = "%s -f %s -m %s -k %d" % (BIN, DATADIR + inst[0], meth, inst[1])
             match = pattern.search(output)
             if not match:
-                print "'%s' failed. No result" % command
+                print "'%s' failed. No result (exit code %d)" % (command, process.returncode)
                 failed += 1
                 continue
 